@@ -0,0 +1,55 @@
+// Host run of the startup and per-attempt I/O benchmarks in main/bench.c over
+// the misc/ dictionaries, normally via the `bench` build target
+//
+//   rabbit_bench <text dir> <packed dict dir> <work dir> [appends]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench.h"
+
+static int64_t host_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4 && argc != 5)
+    {
+        fprintf(stderr, "usage: %s <text dir> <packed dict dir> <work dir> [appends]\n", argv[0]);
+        return 2;
+    }
+    uint32_t appends = argc == 5 ? strtoul(argv[4], NULL, 10) : 1000;
+
+    bench_print_header();
+    for (int digits = 3; digits <= 6; digits++)
+    {
+        char name[8];
+        char text_path[512];
+        char dict_path[512];
+        char compressed_path[512];
+        snprintf(name, sizeof(name), "PIN%d", digits);
+        snprintf(text_path, sizeof(text_path), "%s/%s.TXT", argv[1], name);
+        snprintf(dict_path, sizeof(dict_path), "%s/%s.DIC", argv[2], name);
+        snprintf(compressed_path, sizeof(compressed_path), "%s/%sZ.DIC", argv[2], name);
+
+        const bench_config_t config = {
+            .name = name,
+            .text_path = text_path,
+            .dict_path = dict_path,
+            .compressed_path = compressed_path,
+            .work_dir = argv[3],
+            .appends = appends,
+            .now_us = host_now_us,
+        };
+        if (bench_run(&config) != ESP_OK)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Checks that a dictionary without per-block CRCs is checked against the header CRC when it
+// is opened: the packed dictionaries given load once their flag is cleared, and fail with
+// ESP_ERR_INVALID_CRC once one entry byte is flipped, from a file and from memory
+//
+//   dict_test <dict.DIC...>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dict.h"
+#include "dict_format.h"
+
+static uint8_t *read_file(const char *path, long *size)
+{
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+    {
+        return NULL;
+    }
+    fseek(in, 0, SEEK_END);
+    *size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    uint8_t *data = malloc(*size);
+    if (data != NULL && fread(data, 1, *size, in) != (size_t)*size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(in);
+    return data;
+}
+
+static esp_err_t open_copy(const uint8_t *data, long size, const char *path)
+{
+    FILE *out = fopen(path, "wb");
+    if (out == NULL || fwrite(data, 1, size, out) != (size_t)size || fclose(out) != 0)
+    {
+        return ESP_FAIL;
+    }
+
+    dict_t dict;
+    esp_err_t ret = dict_open(&dict, path);
+    if (ret == ESP_OK)
+    {
+        dict_close(&dict);
+    }
+    remove(path);
+    return ret;
+}
+
+static esp_err_t open_memory(const uint8_t *data, long size)
+{
+    dict_t dict;
+    esp_err_t ret = dict_open_memory(&dict, data, size, "memory");
+    if (ret == ESP_OK)
+    {
+        dict_close(&dict);
+    }
+    return ret;
+}
+
+static int expect(const char *what, const char *path, esp_err_t ret, esp_err_t expected)
+{
+    if (ret == expected)
+    {
+        return 0;
+    }
+    fprintf(stderr, "%s: %s gave %d, expected %d\n", path, what, ret, expected);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <dict.DIC...>\n", argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        long size;
+        uint8_t *data = read_file(argv[i], &size);
+        if (data == NULL || size <= DICT_HEADER_SIZE + 100)
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            return 1;
+        }
+
+        // without the flag the block CRC table is just trailing bytes nothing reads
+        dict_header_t *header = (dict_header_t *)data;
+        header->flags &= ~DICT_FLAG_BLOCK_CRC;
+
+        char path[64];
+        snprintf(path, sizeof(path), "dict_test_%d.DIC", i);
+        failures += expect("unflagged file", argv[i], open_copy(data, size, path), ESP_OK);
+        failures += expect("unflagged memory", argv[i], open_memory(data, size), ESP_OK);
+
+        data[DICT_HEADER_SIZE + 100] ^= 0x01;
+        failures += expect("flipped file", argv[i], open_copy(data, size, path), ESP_ERR_INVALID_CRC);
+        failures += expect("flipped memory", argv[i], open_memory(data, size), ESP_ERR_INVALID_CRC);
+        free(data);
+    }
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
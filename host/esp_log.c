@@ -0,0 +1,3 @@
+#include "esp_log.h"
+
+int esp_log_host_verbose = 0;
@@ -0,0 +1,13 @@
+#pragma once
+
+// Minimal stand-in for ESP-IDF's esp_log.h, errors and warnings go to stderr,
+// info is only printed when the simulator runs verbose
+
+#include <stdio.h>
+
+extern int esp_log_host_verbose;
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) do { if (esp_log_host_verbose) fprintf(stderr, "I (%s) " format "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { } while (0)
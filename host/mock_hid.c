@@ -0,0 +1,77 @@
+#include <string.h>
+#include "mock_hid.h"
+
+static bool mock_hid_wait_ready(void *ctx)
+{
+    return false;
+}
+
+static void mock_hid_prepare(void *ctx, const candidate_t *candidate)
+{
+    mock_hid_t *mock = ctx;
+    hid_stream_passcode(&mock->stream, candidate, &mock->timing);
+}
+
+// play the reports into the text field, one digit per key press
+static esp_err_t mock_hid_type_passcode(void *ctx)
+{
+    mock_hid_t *mock = ctx;
+    size_t length = 0;
+    for (int i = 0; i < mock->stream.count; i++)
+    {
+        const hid_stream_report_t *report = &mock->stream.reports[i];
+        char digit = hid_stream_key_digit(report->keycode[0]);
+        if (digit != '\0' && length < DICT_MAX_DIGITS)
+        {
+            mock->typed[length++] = digit;
+        }
+        virtual_clock_advance(mock->clock, report->hold_us);
+    }
+    mock->typed[length] = '\0';
+    return ESP_OK;
+}
+
+static esp_err_t mock_hid_submit(void *ctx)
+{
+    mock_hid_t *mock = ctx;
+    virtual_clock_advance(mock->clock, (int64_t)mock->timing.key_hold_us + mock->timing.enter_settle_us);
+
+    int64_t now = mock->clock->now_us;
+    if (now < mock->locked_until_us)
+    {
+        mock->wasted++;
+        return ESP_OK;
+    }
+
+    if (!mock->unlocked && mock->secret[0] != '\0' && strcmp(mock->typed, mock->secret) == 0)
+    {
+        mock->unlocked = true;
+        mock->unlocked_at_us = now;
+    }
+
+    mock->attempts++;
+    if (mock->attempts % mock->attempts_per_lockout == 0)
+    {
+        // cap the doubling well before the shift could overflow
+        int32_t doublings = mock->attempts / mock->doubling_attempts;
+        int64_t lockout_us = (int64_t)mock->lockout_seconds * 1000000 << (doublings < 24 ? doublings : 24);
+        mock->locked_until_us = now + lockout_us;
+    }
+    return ESP_OK;
+}
+
+void mock_hid_init(mock_hid_t *mock, virtual_clock_t *clock, hid_sink_t *sink)
+{
+    *mock = (mock_hid_t) {
+        .clock = clock,
+        .attempts_per_lockout = 1,
+        .lockout_seconds = 960,
+        .doubling_attempts = 200,
+        .timing = hid_timing_default,
+    };
+    sink->ctx = mock;
+    sink->wait_ready = mock_hid_wait_ready;
+    sink->prepare = mock_hid_prepare;
+    sink->type_passcode = mock_hid_type_passcode;
+    sink->submit = mock_hid_submit;
+}
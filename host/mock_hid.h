@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "engine.h"
+#include "hid_stream.h"
+#include "virtual_clock.h"
+
+/**
+ * @brief Mock lock screen on the far end of the HID link
+ *
+ * Models the target the firmware is tuned for: attempts_per_lockout tries,
+ * then a lockout of lockout_seconds which doubles every doubling_attempts
+ * attempts. Passcodes submitted while locked out are counted as wasted.
+ * Keystrokes go through the same report streams as on the device and the
+ * mock reads the digits back out of the reports.
+ */
+
+typedef struct {
+    virtual_clock_t *clock;
+    int32_t attempts_per_lockout;
+    int32_t lockout_seconds;
+    int32_t doubling_attempts;
+    char secret[DICT_MAX_DIGITS + 1];   // passcode that unlocks the target, empty for none
+    hid_timing_t timing;                // how long keys are held, the device's default profile
+
+    // state and results
+    hid_stream_t stream;                // reports for the next passcode
+    char typed[DICT_MAX_DIGITS + 1];    // passcode typed but not submitted yet
+    int64_t locked_until_us;
+    uint32_t attempts;                  // accepted attempts
+    uint32_t wasted;                    // attempts submitted during a lockout
+    bool unlocked;
+    int64_t unlocked_at_us;
+} mock_hid_t;
+
+// mock of the target the default schedule is written for
+void mock_hid_init(mock_hid_t *mock, virtual_clock_t *clock, hid_sink_t *sink);
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include "dict_build.h"
+#include "posix_storage.h"
+
+static esp_err_t posix_storage_next_passcode(void *ctx, uint32_t *index, candidate_t *candidate)
+{
+    posix_storage_t *storage = ctx;
+    if ((storage->power_cut_after != 0 && storage->handed_out == storage->power_cut_after)
+        || (storage->stop != NULL && *storage->stop))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = dict_chain_next(&storage->chain, index, candidate);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    storage->handed_out++;
+    return ESP_OK;
+}
+
+static uint32_t posix_storage_log_attempt(void *ctx, const journal_record_t *record)
+{
+    posix_storage_t *storage = ctx;
+    journal_record_t copy = *record;
+    journal_append(&storage->journal, &copy);
+    return copy.sequence;
+}
+
+static esp_err_t posix_storage_wait_durable(void *ctx, uint32_t ticket)
+{
+    posix_storage_t *storage = ctx;
+    if (++storage->syncs == storage->fail_sync_at)
+    {
+        return ESP_FAIL;
+    }
+    esp_err_t ret = journal_commit(&storage->journal);
+    if (ret == ESP_OK)
+    {
+        storage->durable++;
+    }
+    return ret;
+}
+
+static void posix_storage_save_checkpoint(void *ctx, const checkpoint_state_t *state)
+{
+    posix_storage_t *storage = ctx;
+    visited_save(&storage->visited);
+    storage->checkpoint.state = *state;
+    checkpoint_save(&storage->checkpoint);
+}
+
+static void posix_storage_suspend(void *ctx)
+{
+    posix_storage_t *storage = ctx;
+    journal_commit(&storage->journal);
+    storage->suspends++;
+}
+
+static void posix_storage_resume(void *ctx)
+{
+}
+
+esp_err_t posix_storage_open(posix_storage_t *storage, const char *dict_paths, const char *dir,
+                             engine_t *engine, engine_storage_t *backend)
+{
+    char checkpoint_path[512];
+    char journal_path[512];
+    char visited_path[512];
+    snprintf(checkpoint_path, sizeof(checkpoint_path), "%s/RESUME.CKP", dir);
+    snprintf(journal_path, sizeof(journal_path), "%s/ATTEMPTS.JNL", dir);
+    snprintf(visited_path, sizeof(visited_path), "%s/VISITED.BIT", dir);
+
+    storage->handed_out = 0;
+    storage->syncs = 0;
+    storage->durable = 0;
+
+    esp_err_t ret = dict_chain_open(&storage->chain, dict_paths, dict_open_or_build);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    ret = visited_open(&storage->visited, visited_path, storage->chain.lengths);
+    if (ret != ESP_OK)
+    {
+        dict_chain_close(&storage->chain);
+        return ret;
+    }
+    storage->chain.visited = &storage->visited;
+    engine->visited = &storage->visited;
+
+    ret = checkpoint_open(&storage->checkpoint, checkpoint_path);
+    if (ret != ESP_OK)
+    {
+        visited_close(&storage->visited);
+        dict_chain_close(&storage->chain);
+        return ret;
+    }
+
+    const journal_config_t journal_config = {
+        .base_path = dir,
+        .path = journal_path,
+        .sync_policy = JOURNAL_SYNC_COMMIT,
+    };
+    ret = journal_open(&storage->journal, &journal_config);
+    if (ret != ESP_OK)
+    {
+        checkpoint_close(&storage->checkpoint);
+        visited_close(&storage->visited);
+        dict_chain_close(&storage->chain);
+        return ret;
+    }
+
+    engine_resume(engine, &storage->chain, &storage->checkpoint, NULL);
+    dict_chain_seek(&storage->chain, engine->starting_index);
+
+    *backend = (engine_storage_t) {
+        .ctx = storage,
+        .next_passcode = posix_storage_next_passcode,
+        .log_attempt = posix_storage_log_attempt,
+        .wait_durable = posix_storage_wait_durable,
+        .save_checkpoint = posix_storage_save_checkpoint,
+        .suspend = posix_storage_suspend,
+        .resume = posix_storage_resume,
+    };
+    engine->storage = backend;
+
+    return ESP_OK;
+}
+
+void posix_storage_close(posix_storage_t *storage)
+{
+    journal_close(&storage->journal);
+    checkpoint_close(&storage->checkpoint);
+    visited_close(&storage->visited);
+    dict_chain_close(&storage->chain);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include "engine.h"
+
+/**
+ * @brief Engine storage backend doing synchronous POSIX file I/O
+ *
+ * Same files and formats as the firmware (which goes through the storage
+ * task), with the journal, checkpoint and visited set under one directory.
+ */
+typedef struct {
+    dict_chain_t chain;
+    visited_t visited;
+    checkpoint_t checkpoint;
+    journal_t journal;
+    uint32_t power_cut_after;           // stop handing out passcodes after this many, 0 for never
+    const bool *stop;                   // stop handing out passcodes once this is true, may be NULL
+    uint32_t fail_sync_at;              // journal sync of this attempt (counting from 1) fails, 0 for never
+    uint32_t syncs;                     // journal syncs asked for
+    uint32_t durable;                   // attempts reported as on the card
+    uint32_t handed_out;
+    uint32_t suspends;                  // lockouts the card would have been powered down for
+} posix_storage_t;
+
+// open the comma separated dictionaries in `dict_paths` and everything else under `dir`, and resume
+// `engine` from the checkpoint
+esp_err_t posix_storage_open(posix_storage_t *storage, const char *dict_paths, const char *dir,
+                             engine_t *engine, engine_storage_t *backend);
+
+void posix_storage_close(posix_storage_t *storage);
@@ -0,0 +1,179 @@
+// Host simulation of a whole run: the real attempt engine, dictionary, journal
+// and checkpoint code against a mock lock screen and a virtual clock
+//
+//   rabbit_sim [-v] [-k] [-x] [-s secret] [-p attempts] [-f attempt] <dict.DIC[,dict.DIC...]> <workdir>
+//
+//   -v  print the engine's info logs
+//   -k  keep the checkpoint, journal and visited set already in workdir (default starts afresh)
+//   -s  passcode that unlocks the mock target, reports when it was found
+//   -x  end the run as soon as the target unlocks
+//   -p  cut the power after this many attempts and reboot, to exercise resume
+//   -f  fail the journal sync of this attempt (counting from 1 in each boot)
+//
+// Exits with 1 if a dictionary could not be read to the end, any attempt was wasted during a
+// lockout, or the target given with -s never unlocked. With -f it instead exits with 0 only if the
+// run stopped at the failed sync. In every case an attempt submitted before its journal record was
+// on disk is a failure
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "mock_hid.h"
+#include "posix_storage.h"
+#include "virtual_clock.h"
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-v] [-k] [-x] [-s secret] [-p attempts] [-f attempt] <dict.DIC[,dict.DIC...]> <workdir>\n", argv0);
+    exit(2);
+}
+
+static void print_duration(const char *label, int64_t us)
+{
+    int64_t seconds = us / 1000000;
+    printf("%-20s %lldd %02lldh %02lldm %02llds\n", label, (long long)(seconds / 86400),
+           (long long)(seconds / 3600 % 24), (long long)(seconds / 60 % 60), (long long)(seconds % 60));
+}
+
+int main(int argc, char **argv)
+{
+    bool keep = false;
+    bool stop_on_unlock = false;
+    const char *secret = NULL;
+    uint32_t power_cut_after = 0;
+    uint32_t fail_sync_at = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "vkxs:p:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'v':
+            esp_log_host_verbose = 1;
+            break;
+        case 'k':
+            keep = true;
+            break;
+        case 'x':
+            stop_on_unlock = true;
+            break;
+        case 's':
+            secret = optarg;
+            break;
+        case 'p':
+            power_cut_after = strtoul(optarg, NULL, 10);
+            break;
+        case 'f':
+            fail_sync_at = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (argc - optind != 2)
+    {
+        usage(argv[0]);
+    }
+    const char *dict_path = argv[optind];
+    const char *dir = argv[optind + 1];
+
+    if (!keep)
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/RESUME.CKP", dir);
+        remove(path);
+        snprintf(path, sizeof(path), "%s/ATTEMPTS.JNL", dir);
+        remove(path);
+        snprintf(path, sizeof(path), "%s/VISITED.BIT", dir);
+        remove(path);
+    }
+
+    virtual_clock_t vclock;
+    engine_clock_t engine_clock;
+    virtual_clock_init(&vclock, &engine_clock);
+
+    mock_hid_t mock;
+    hid_sink_t hid;
+    mock_hid_init(&mock, &vclock, &hid);
+    if (secret != NULL)
+    {
+        snprintf(mock.secret, sizeof(mock.secret), "%s", secret);
+    }
+
+    clock_t started = clock();
+    uint32_t boots = 0;
+    uint32_t suspends = 0;
+    uint32_t skipped = 0;
+    uint32_t durable = 0;
+    bool failed = false;                // the run stopped on a dictionary it could not read or a failed sync
+    for (;;)
+    {
+        engine_t engine = {
+            .hid = &hid,
+            .clock = &engine_clock,
+        };
+        posix_storage_t storage = {
+            .power_cut_after = power_cut_after,
+            .stop = stop_on_unlock ? &mock.unlocked : NULL,
+            .fail_sync_at = fail_sync_at,
+        };
+        engine_storage_t backend;
+        if (posix_storage_open(&storage, dict_path, dir, &engine, &backend) != ESP_OK)
+        {
+            return 1;
+        }
+        boots++;
+
+        esp_err_t ret = engine_run(&engine);
+        bool finished = storage.chain.current == storage.chain.sources;
+        suspends += storage.suspends;
+        skipped += storage.chain.skipped;
+        durable += storage.durable;
+        posix_storage_close(&storage);
+        if (ret != ESP_OK)
+        {
+            failed = true;
+            break;
+        }
+
+        if (finished || power_cut_after == 0 || (stop_on_unlock && mock.unlocked))
+        {
+            break;
+        }
+    }
+    double wall_ms = (double)(clock() - started) * 1000 / CLOCKS_PER_SEC;
+
+    printf("%-20s %lu\n", "boots", (unsigned long)boots);
+    printf("%-20s %lu\n", "attempts accepted", (unsigned long)mock.attempts);
+    printf("%-20s %lu\n", "attempts wasted", (unsigned long)mock.wasted);
+    uint32_t submitted = mock.attempts + mock.wasted;
+    bool unjournalled = submitted > durable;
+    if (unjournalled)
+    {
+        printf("%-20s %lu\n", "not in the journal", (unsigned long)(submitted - durable));
+    }
+    printf("%-20s %lu\n", "duplicates skipped", (unsigned long)skipped);
+    printf("%-20s %lu\n", "card power-downs", (unsigned long)suspends);
+    print_duration("simulated time", vclock.now_us);
+    if (secret != NULL)
+    {
+        if (mock.unlocked)
+        {
+            print_duration("unlocked after", mock.unlocked_at_us);
+        }
+        else
+        {
+            printf("%-20s %s\n", "unlocked after", "never");
+        }
+    }
+    printf("%-20s %.1f ms\n", "wall time", wall_ms);
+
+    if (fail_sync_at != 0)
+    {
+        return failed && !unjournalled ? 0 : 1;
+    }
+    return failed || unjournalled || mock.wasted > 0 || (secret != NULL && !mock.unlocked) ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+#include "virtual_clock.h"
+
+static int64_t virtual_clock_now_us(void *ctx)
+{
+    virtual_clock_t *clock = ctx;
+    return clock->now_us;
+}
+
+static void virtual_clock_sleep_until(void *ctx, int64_t deadline_us)
+{
+    virtual_clock_t *clock = ctx;
+    if (deadline_us > clock->now_us)
+    {
+        clock->slept_us += deadline_us - clock->now_us;
+        clock->now_us = deadline_us;
+    }
+}
+
+void virtual_clock_init(virtual_clock_t *clock, engine_clock_t *engine_clock)
+{
+    clock->now_us = 0;
+    clock->slept_us = 0;
+    engine_clock->ctx = clock;
+    engine_clock->now_us = virtual_clock_now_us;
+    engine_clock->sleep_until = virtual_clock_sleep_until;
+}
+
+void virtual_clock_advance(virtual_clock_t *clock, int64_t us)
+{
+    clock->now_us += us;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include "engine.h"
+
+/**
+ * @brief Virtual clock, sleeping jumps straight to the deadline
+ *
+ * Lets a run with days of lockouts be simulated in milliseconds.
+ */
+typedef struct {
+    int64_t now_us;
+    int64_t slept_us;                   // total time spent sleeping
+} virtual_clock_t;
+
+void virtual_clock_init(virtual_clock_t *clock, engine_clock_t *engine_clock);
+
+// move time forwards, e.g. for time spent typing
+void virtual_clock_advance(virtual_clock_t *clock, int64_t us);
@@ -0,0 +1,391 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "bench.h"
+#include "dict.h"
+#include "text_tokenizer.h"
+#include "checkpoint.h"
+#include "journal.h"
+
+#define LOG_TAG                "bench"
+#define BENCH_PATH_MAX         256
+#define BENCH_CHUNK_SIZE       4096    // bytes per write and read in the throughput probe
+
+static void bench_report(const bench_config_t *config, const char *what, uint32_t ops, int64_t elapsed_us)
+{
+    printf("%-6s %-30s %10lu %12.3f %12.3f\n", config->name, what, (unsigned long)ops,
+           elapsed_us / 1000.0, ops > 0 ? (double)elapsed_us / ops : 0.0);
+}
+
+void bench_print_header(void)
+{
+    printf("%-6s %-30s %10s %12s %12s\n", "dict", "benchmark", "ops", "total ms", "us/op");
+}
+
+// original startup path: parse every passcode in the text dictionary with fscanf
+static esp_err_t bench_legacy_parse(const bench_config_t *config)
+{
+    int64_t start = config->now_us();
+    FILE *f = fopen(config->text_path, "r");
+    if (f == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    int passcode;
+    uint32_t count = 0;
+    while (fscanf(f, "%d", &passcode) == 1)
+    {
+        count++;
+    }
+    fclose(f);
+    bench_report(config, "text parse (fscanf)", count, config->now_us() - start);
+
+    return ESP_OK;
+}
+
+// replacement text parse: the streaming tokenizer over the block reader
+static esp_err_t bench_tokenizer_parse(const bench_config_t *config)
+{
+    int64_t start = config->now_us();
+    text_tokenizer_t tok;
+    esp_err_t ret = text_tokenizer_open(&tok, config->text_path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    candidate_t candidate;
+    uint32_t count = 0;
+    while (text_tokenizer_next(&tok, &candidate) == ESP_OK)
+    {
+        count++;
+    }
+    text_tokenizer_close(&tok);
+    bench_report(config, "text parse (tokenizer)", count, config->now_us() - start);
+
+    return ESP_OK;
+}
+
+// original resume path: skip through the text dictionary until the starting passcode
+static esp_err_t bench_legacy_skip(const bench_config_t *config, int target)
+{
+    int64_t start = config->now_us();
+    FILE *f = fopen(config->text_path, "r");
+    if (f == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    int passcode = -1;
+    uint32_t count = 0;
+    do
+    {
+        if (fscanf(f, "%d", &passcode) != 1)
+        {
+            break;
+        }
+        count++;
+    } while (passcode != target);
+    fclose(f);
+    bench_report(config, "skip to last (fscanf)", count, config->now_us() - start);
+
+    return ESP_OK;
+}
+
+static esp_err_t bench_packed_read(const bench_config_t *config, const char *path, const char *what)
+{
+    if (path == NULL)
+    {
+        return ESP_OK;
+    }
+
+    int64_t start = config->now_us();
+    dict_t dict;
+    esp_err_t ret = dict_open(&dict, path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    candidate_t candidate;
+    uint32_t count = 0;
+    while (dict_next(&dict, &candidate) == ESP_OK)
+    {
+        count++;
+    }
+    dict_close(&dict);
+    bench_report(config, what, count, config->now_us() - start);
+
+    return ESP_OK;
+}
+
+// replacement resume path, also returns the last passcode for the skip benchmark
+static esp_err_t bench_packed_seek(const bench_config_t *config, candidate_t *last)
+{
+    int64_t start = config->now_us();
+    dict_t dict;
+    esp_err_t ret = dict_open(&dict, config->dict_path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    ret = dict_seek(&dict, dict.count - 1);
+    if (ret == ESP_OK)
+    {
+        ret = dict_next(&dict, last);
+    }
+    dict_close(&dict);
+    bench_report(config, "seek to last (packed)", 1, config->now_us() - start);
+
+    return ret;
+}
+
+// copy the text dictionary to a pin.log as if every passcode had been tried by old firmware
+static esp_err_t bench_make_legacy_log(const bench_config_t *config, const char *log_path)
+{
+    FILE *in = fopen(config->text_path, "r");
+    FILE *out = fopen(log_path, "w");
+    if (in == NULL || out == NULL)
+    {
+        if (in != NULL)
+        {
+            fclose(in);
+        }
+        if (out != NULL)
+        {
+            fclose(out);
+        }
+        return ESP_FAIL;
+    }
+
+    char buffer[512];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        fwrite(buffer, 1, length, out);
+    }
+    fclose(in);
+    fclose(out);
+
+    return ESP_OK;
+}
+
+// original resume path: read_last_passcode over a pin.log holding the whole dictionary
+static esp_err_t bench_legacy_resume(const bench_config_t *config, const char *log_path)
+{
+    esp_err_t ret = bench_make_legacy_log(config, log_path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    int64_t start = config->now_us();
+    FILE *f = fopen(log_path, "r");
+    if (f == NULL)
+    {
+        return ESP_FAIL;
+    }
+    int passcode = 0;
+    uint32_t count = 0;
+    while (!feof(f))
+    {
+        if (fscanf(f, "%d", &passcode) == 1)
+        {
+            count++;
+        }
+    }
+    fclose(f);
+    bench_report(config, "resume from pin.log", count, config->now_us() - start);
+
+    return ESP_OK;
+}
+
+static esp_err_t bench_checkpoint_resume(const bench_config_t *config, const char *checkpoint_path)
+{
+    checkpoint_t checkpoint;
+    esp_err_t ret = checkpoint_open(&checkpoint, checkpoint_path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    checkpoint.state.dict_index = 1;
+    ret = checkpoint_save(&checkpoint);
+    checkpoint_close(&checkpoint);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    int64_t start = config->now_us();
+    ret = checkpoint_open(&checkpoint, checkpoint_path);
+    checkpoint_close(&checkpoint);
+    bench_report(config, "resume from checkpoint", 1, config->now_us() - start);
+
+    return ret;
+}
+
+// original per-attempt logging: write_line's fopen/fprintf/fclose
+static esp_err_t bench_legacy_append(const bench_config_t *config, const char *log_path)
+{
+    remove(log_path);
+
+    int64_t start = config->now_us();
+    for (uint32_t i = 0; i < config->appends; i++)
+    {
+        FILE *f = fopen(log_path, "a");
+        if (f == NULL)
+        {
+            return ESP_FAIL;
+        }
+        fprintf(f, "%04lu\n", (unsigned long)(i % 10000));
+        fclose(f);
+    }
+    bench_report(config, "append (fopen/fprintf/fclose)", config->appends, config->now_us() - start);
+
+    return ESP_OK;
+}
+
+// on the card fclose() syncs the FAT file just like a journal commit, on the host it does not,
+// so the journal is timed both with and without syncing every record
+static esp_err_t bench_journal_append(const bench_config_t *config, const char *journal_path,
+                                      journal_sync_policy_t sync_policy, const char *what)
+{
+    remove(journal_path);
+
+    journal_t journal;
+    const journal_config_t journal_config = {
+        .base_path = config->work_dir,
+        .path = journal_path,
+        .prealloc_size = config->appends * JOURNAL_RECORD_SIZE,
+        .sync_policy = sync_policy,
+    };
+    esp_err_t ret = journal_open(&journal, &journal_config);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    int64_t start = config->now_us();
+    for (uint32_t i = 0; i < config->appends && ret == ESP_OK; i++)
+    {
+        journal_record_t record = {
+            .type = JOURNAL_RECORD_ATTEMPT,
+            .digits = 4,
+            .dict_index = i,
+            .passcode = i % 10000,
+        };
+        ret = journal_append(&journal, &record);
+        if (ret == ESP_OK)
+        {
+            ret = journal_commit(&journal);
+        }
+    }
+    bench_report(config, what, config->appends, config->now_us() - start);
+    journal_close(&journal);
+
+    return ret;
+}
+
+esp_err_t bench_run(const bench_config_t *config)
+{
+    char log_path[BENCH_PATH_MAX];
+    char checkpoint_path[BENCH_PATH_MAX];
+    char journal_path[BENCH_PATH_MAX];
+    snprintf(log_path, sizeof(log_path), "%s/pin.log", config->work_dir);
+    snprintf(checkpoint_path, sizeof(checkpoint_path), "%s/BENCH.CKP", config->work_dir);
+    snprintf(journal_path, sizeof(journal_path), "%s/BENCH.JNL", config->work_dir);
+
+    candidate_t last = {0};
+    esp_err_t ret = ESP_OK;
+    if ((ret = bench_legacy_parse(config)) != ESP_OK
+        || (ret = bench_tokenizer_parse(config)) != ESP_OK
+        || (ret = bench_packed_read(config, config->dict_path, "packed read")) != ESP_OK
+        || (ret = bench_packed_read(config, config->compressed_path, "compressed read")) != ESP_OK
+        || (ret = bench_packed_seek(config, &last)) != ESP_OK
+        || (ret = bench_legacy_skip(config, last.value)) != ESP_OK
+        || (ret = bench_legacy_resume(config, log_path)) != ESP_OK
+        || (ret = bench_checkpoint_resume(config, checkpoint_path)) != ESP_OK
+        || (ret = bench_legacy_append(config, log_path)) != ESP_OK
+        || (ret = bench_journal_append(config, journal_path, JOURNAL_SYNC_CLOSE, "append (journal)")) != ESP_OK
+        || (ret = bench_journal_append(config, journal_path, JOURNAL_SYNC_COMMIT, "append (journal + fsync)")) != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "%s: benchmark failed (%d)", config->name, ret);
+    }
+
+    remove(log_path);
+    remove(checkpoint_path);
+    remove(journal_path);
+
+    return ret;
+}
+
+static uint32_t bench_kbps(uint32_t bytes, int64_t elapsed_us)
+{
+    return elapsed_us > 0 ? (uint32_t)((int64_t)bytes * 1000000 / 1024 / elapsed_us) : 0;
+}
+
+esp_err_t bench_throughput(const char *path, uint32_t size, int64_t (*now_us)(void),
+                           uint32_t *write_kbps, uint32_t *read_kbps)
+{
+    uint8_t *written = malloc(BENCH_CHUNK_SIZE);
+    uint8_t *read_back = malloc(BENCH_CHUNK_SIZE);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (written == NULL || read_back == NULL || fd < 0)
+    {
+        free(written);
+        free(read_back);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return fd < 0 ? ESP_FAIL : ESP_ERR_NO_MEM;
+    }
+
+    // every chunk starts with its own number, so a chunk landing in the wrong place shows up too
+    for (uint32_t i = 0; i < BENCH_CHUNK_SIZE; i++)
+    {
+        written[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    uint32_t chunks = size / BENCH_CHUNK_SIZE;
+    esp_err_t ret = ESP_OK;
+    int64_t start = now_us();
+    for (uint32_t chunk = 0; chunk < chunks && ret == ESP_OK; chunk++)
+    {
+        memcpy(written, &chunk, sizeof(chunk));
+        if (write(fd, written, BENCH_CHUNK_SIZE) != BENCH_CHUNK_SIZE)
+        {
+            ret = ESP_FAIL;
+        }
+    }
+    if (ret == ESP_OK && fsync(fd) != 0)
+    {
+        ret = ESP_FAIL;
+    }
+    *write_kbps = bench_kbps(chunks * BENCH_CHUNK_SIZE, now_us() - start);
+
+    start = now_us();
+    if (ret == ESP_OK && lseek(fd, 0, SEEK_SET) != 0)
+    {
+        ret = ESP_FAIL;
+    }
+    for (uint32_t chunk = 0; chunk < chunks && ret == ESP_OK; chunk++)
+    {
+        memcpy(written, &chunk, sizeof(chunk));
+        if (read(fd, read_back, BENCH_CHUNK_SIZE) != BENCH_CHUNK_SIZE)
+        {
+            ret = ESP_FAIL;
+        }
+        else if (memcmp(read_back, written, BENCH_CHUNK_SIZE) != 0)
+        {
+            ret = ESP_ERR_INVALID_CRC;
+        }
+    }
+    *read_kbps = bench_kbps(chunks * BENCH_CHUNK_SIZE, now_us() - start);
+
+    close(fd);
+    remove(path);
+    free(written);
+    free(read_back);
+    return ret;
+}
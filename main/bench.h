@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Startup and per-attempt I/O benchmarks
+ *
+ * Times the original text based paths (fscanf over the dictionary, the
+ * skip-ahead loop, read_last_passcode over pin.log, fopen/fprintf/fclose per
+ * attempt) against their replacements (streaming tokenizer, packed
+ * dictionary, seek, checkpoint, journal) on the same data. Shared by the host bench and the firmware, which
+ * prints the results on the console.
+ */
+
+typedef struct {
+    const char *name;                   // label for the results, e.g. "PIN4"
+    const char *text_path;              // text dictionary, one passcode per line
+    const char *dict_path;              // the same dictionary packed by pin2dict
+    const char *compressed_path;        // and compressed by pin2dict -z, NULL to skip
+    const char *work_dir;               // scratch directory for logs, journal and checkpoint
+    uint32_t appends;                   // attempts to log in the append benchmarks
+    int64_t (*now_us)(void);
+} bench_config_t;
+
+// run every benchmark for one dictionary and print a line per result
+esp_err_t bench_run(const bench_config_t *config);
+
+// print the column headings for bench_run()'s output
+void bench_print_header(void);
+
+// write `size` bytes to a scratch file at `path` with an fsync, read them back and check them,
+// giving the rates in KB/s. Returns ESP_ERR_INVALID_CRC if the card returned different data
+esp_err_t bench_throughput(const char *path, uint32_t size, int64_t (*now_us)(void),
+                           uint32_t *write_kbps, uint32_t *read_kbps);
@@ -0,0 +1,239 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "block_reader.h"
+#include "crc32.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#define LOG_TAG                "block_reader"
+
+static uint8_t *block_reader_alloc(void)
+{
+#ifdef ESP_PLATFORM
+    // word aligned DMA-capable memory lets the SDMMC host transfer without a bounce buffer
+    return heap_caps_aligned_alloc(4, BLOCK_READER_BLOCK_SIZE, MALLOC_CAP_DMA);
+#else
+    return malloc(BLOCK_READER_BLOCK_SIZE);
+#endif
+}
+
+static void block_reader_free(uint8_t *buffer)
+{
+#ifdef ESP_PLATFORM
+    heap_caps_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+static uint32_t block_reader_block_count(const block_reader_t *reader)
+{
+    return block_reader_blocks_for(reader->size);
+}
+
+// check `block`, loaded at `data`, against its CRC from the table if there is one
+static esp_err_t block_reader_check(const block_reader_t *reader, uint32_t block, const uint8_t *data, size_t length)
+{
+    if (reader->block_crcs == NULL || crc32_update(0, data, length) == reader->block_crcs[block])
+    {
+        return ESP_OK;
+    }
+    ESP_LOGE(LOG_TAG, "Block %lu fails its CRC", (unsigned long)block);
+    return ESP_ERR_INVALID_CRC;
+}
+
+// read `block` into buffer `index`
+static esp_err_t block_reader_fill(block_reader_t *reader, int index, uint32_t block)
+{
+    off_t offset = (off_t)block * BLOCK_READER_BLOCK_SIZE;
+    size_t wanted = reader->size - offset < BLOCK_READER_BLOCK_SIZE ? reader->size - offset : BLOCK_READER_BLOCK_SIZE;
+
+    reader->block[index] = BLOCK_READER_NO_BLOCK;
+    if (pread(reader->fd, reader->buffers[index], wanted, offset) != (ssize_t)wanted)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to read block %lu", (unsigned long)block);
+        return ESP_FAIL;
+    }
+    esp_err_t ret = block_reader_check(reader, block, reader->buffers[index], wanted);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    reader->block[index] = block;
+    reader->length[index] = wanted;
+
+    return ESP_OK;
+}
+
+esp_err_t block_reader_open(block_reader_t *reader, const char *path)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->block[0] = reader->block[1] = BLOCK_READER_NO_BLOCK;
+
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0)
+    {
+        block_reader_close(reader);
+        return ESP_FAIL;
+    }
+    reader->size = st.st_size;
+
+    reader->buffers[0] = block_reader_alloc();
+    reader->buffers[1] = block_reader_alloc();
+    if (reader->buffers[0] == NULL || reader->buffers[1] == NULL)
+    {
+        block_reader_close(reader);
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t block_reader_open_memory(block_reader_t *reader, const void *data, uint32_t size)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->block[0] = reader->block[1] = BLOCK_READER_NO_BLOCK;
+    reader->fd = -1;
+    reader->memory = data;
+    reader->size = size;
+
+    return ESP_OK;
+}
+
+void block_reader_close(block_reader_t *reader)
+{
+    if (reader->fd >= 0)
+    {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        block_reader_free(reader->buffers[i]);
+        reader->buffers[i] = NULL;
+    }
+    free(reader->block_crcs);
+    reader->block_crcs = NULL;
+}
+
+esp_err_t block_reader_verify_blocks(block_reader_t *reader, uint32_t size)
+{
+    uint32_t table_size = block_reader_blocks_for(size) * sizeof(uint32_t);
+    if (size > reader->size || reader->size - size < table_size)
+    {
+        ESP_LOGE(LOG_TAG, "No block CRC table");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t *crcs = malloc(table_size > 0 ? table_size : 1);
+    if (crcs == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (reader->memory != NULL)
+    {
+        memcpy(crcs, reader->memory + size, table_size);
+    }
+    else if (pread(reader->fd, crcs, table_size, size) != (ssize_t)table_size)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to read the block CRC table");
+        free(crcs);
+        return ESP_FAIL;
+    }
+
+    free(reader->block_crcs);
+    reader->block_crcs = crcs;
+    reader->size = size;
+    // whatever is buffered was read unchecked
+    reader->block[0] = reader->block[1] = BLOCK_READER_NO_BLOCK;
+
+    return ESP_OK;
+}
+
+const uint8_t *block_reader_get(block_reader_t *reader, uint32_t block, size_t *length)
+{
+    if (reader->memory != NULL)
+    {
+        if (block >= block_reader_block_count(reader))
+        {
+            return NULL;
+        }
+        uint32_t offset = block * BLOCK_READER_BLOCK_SIZE;
+        *length = reader->size - offset < BLOCK_READER_BLOCK_SIZE ? reader->size - offset : BLOCK_READER_BLOCK_SIZE;
+        // block[0] remembers the last block checked, so runs of reads within one block check it once
+        if (reader->block_crcs != NULL && reader->block[0] != block)
+        {
+            if (block_reader_check(reader, block, reader->memory + offset, *length) != ESP_OK)
+            {
+                return NULL;
+            }
+            reader->block[0] = block;
+        }
+        return reader->memory + offset;
+    }
+
+    if (reader->block[reader->current] != block)
+    {
+        // swap to the other buffer, which is either the prefetched block or gets loaded now
+        reader->current ^= 1;
+        if (reader->block[reader->current] != block
+            && (block >= block_reader_block_count(reader) || block_reader_fill(reader, reader->current, block) != ESP_OK))
+        {
+            return NULL;
+        }
+    }
+
+    *length = reader->length[reader->current];
+    return reader->buffers[reader->current];
+}
+
+esp_err_t block_reader_prefetch(block_reader_t *reader)
+{
+    uint32_t current = reader->block[reader->current];
+    if (reader->memory != NULL || current == BLOCK_READER_NO_BLOCK || current + 1 >= block_reader_block_count(reader))
+    {
+        return ESP_OK;
+    }
+
+    int idle = reader->current ^ 1;
+    if (reader->block[idle] == current + 1)
+    {
+        return ESP_OK;
+    }
+    return block_reader_fill(reader, idle, current + 1);
+}
+
+esp_err_t block_reader_read(block_reader_t *reader, uint32_t offset, void *data, size_t length)
+{
+    uint8_t *out = data;
+    while (length > 0)
+    {
+        size_t available;
+        const uint8_t *block = block_reader_get(reader, offset / BLOCK_READER_BLOCK_SIZE, &available);
+        size_t within = offset % BLOCK_READER_BLOCK_SIZE;
+        if (block == NULL || within >= available)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        size_t chunk = available - within < length ? available - within : length;
+        memcpy(out, block + within, chunk);
+        out += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/**
+ * @brief Double-buffered, sector aligned file reader
+ *
+ * Reads a file in whole BLOCK_READER_BLOCK_SIZE blocks, bypassing stdio,
+ * into two DMA-capable buffers so the SDMMC driver can transfer straight
+ * into them. While the caller consumes one buffer, block_reader_prefetch()
+ * can fill the other with the following block, so sequential reads only
+ * wait on the card if the prefetch has not been run.
+ *
+ * A reader can also be opened over memory (e.g. a flash partition mapped
+ * through the cache), in which case blocks are handed out in place and no
+ * buffers or reads are involved.
+ *
+ * Files whose data is followed by a table with the CRC32 of each of its
+ * blocks can be verified as they are read: after block_reader_verify_blocks() every block
+ * is checked when it is loaded, prefetches included, or for memory when it
+ * is first handed out, and one that does not match is never handed out.
+ */
+
+#define BLOCK_READER_BLOCK_SIZE  4096        // matches CONFIG_FATFS_SECTOR_4096
+#define BLOCK_READER_NO_BLOCK    UINT32_MAX
+
+typedef struct {
+    int fd;                             // -1 when reading from memory
+    const uint8_t *memory;              // contents when reading from memory, otherwise NULL
+    uint32_t size;                      // file size in bytes
+    uint8_t *buffers[2];
+    uint32_t block[2];                  // block number held by each buffer, BLOCK_READER_NO_BLOCK if none
+    size_t length[2];                   // valid bytes in each buffer
+    int current;                        // buffer most recently handed out
+    uint32_t *block_crcs;               // expected CRC32 of each block when verifying, otherwise NULL
+} block_reader_t;
+
+// number of blocks in `size` bytes of data, and so of CRC32s in the table that follows them
+static inline uint32_t block_reader_blocks_for(uint32_t size)
+{
+    return (size + BLOCK_READER_BLOCK_SIZE - 1) / BLOCK_READER_BLOCK_SIZE;
+}
+
+esp_err_t block_reader_open(block_reader_t *reader, const char *path);
+
+// read `size` bytes at `data` instead of a file, which must stay mapped until the reader is closed
+esp_err_t block_reader_open_memory(block_reader_t *reader, const void *data, uint32_t size);
+
+void block_reader_close(block_reader_t *reader);
+
+// load the table holding the CRC32 of each block of the first `size` bytes, which follows them,
+// and check every block against it from now on. The reader's size shrinks to `size`
+esp_err_t block_reader_verify_blocks(block_reader_t *reader, uint32_t size);
+
+// pointer to the contents of `block`, reading it from the card unless already buffered.
+// Stays valid until the next-but-one call
+const uint8_t *block_reader_get(block_reader_t *reader, uint32_t block, size_t *length);
+
+// read the block after the current one into the idle buffer, if not there already
+esp_err_t block_reader_prefetch(block_reader_t *reader);
+
+// copy `length` bytes starting at file offset `offset`, crossing block boundaries as needed
+esp_err_t block_reader_read(block_reader_t *reader, uint32_t offset, void *data, size_t length);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief A passcode to try
+ *
+ * The numeric value alone loses leading zeros ("000123" and "123" are both
+ * 123), so a candidate always travels with its length.
+ */
+typedef struct {
+    uint32_t value;
+    uint8_t digits;
+} candidate_t;
@@ -0,0 +1,118 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "checkpoint.h"
+#include "crc32.h"
+
+#define LOG_TAG                "checkpoint"
+#define CHECKPOINT_MAGIC       0x50434B52      // "RKCP"
+#define CHECKPOINT_VERSION     2
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;                  // sizeof(checkpoint_record_t)
+    uint32_t sequence;
+    checkpoint_state_t state;
+    uint32_t crc32;                 // CRC32 of everything above
+} checkpoint_record_t;
+
+_Static_assert(sizeof(checkpoint_record_t) <= CHECKPOINT_SLOT_SIZE, "checkpoint record must fit in a slot");
+
+static bool checkpoint_record_valid(const checkpoint_record_t *record)
+{
+    return record->magic == CHECKPOINT_MAGIC
+        && record->version == CHECKPOINT_VERSION
+        && record->size == sizeof(*record)
+        && record->crc32 == crc32_update(0, record, offsetof(checkpoint_record_t, crc32));
+}
+
+// read the record at the start of a slot, returns false if it is missing or damaged
+static bool checkpoint_read_slot(FILE *file, int slot, checkpoint_record_t *record)
+{
+    if (fseek(file, (long)slot * CHECKPOINT_SLOT_SIZE, SEEK_SET) != 0
+        || fread(record, sizeof(*record), 1, file) != 1)
+    {
+        return false;
+    }
+    return checkpoint_record_valid(record);
+}
+
+esp_err_t checkpoint_open(checkpoint_t *cp, const char *path)
+{
+    memset(cp, 0, sizeof(*cp));
+
+    cp->file = fopen(path, "r+b");
+    if (cp->file == NULL)
+    {
+        cp->file = fopen(path, "w+b");
+    }
+    if (cp->file == NULL)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+
+    checkpoint_record_t slots[2];
+    bool valid[2];
+    for (int i = 0; i < 2; i++)
+    {
+        valid[i] = checkpoint_read_slot(cp->file, i, &slots[i]);
+    }
+
+    int newest = -1;
+    if (valid[0] && valid[1])
+    {
+        newest = slots[1].sequence > slots[0].sequence ? 1 : 0;
+    }
+    else if (valid[0] || valid[1])
+    {
+        newest = valid[0] ? 0 : 1;
+    }
+
+    if (newest >= 0)
+    {
+        cp->sequence = slots[newest].sequence;
+        cp->state = slots[newest].state;
+        ESP_LOGI(LOG_TAG, "Loaded checkpoint #%lu from slot %d", (unsigned long)cp->sequence, newest);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t checkpoint_save(checkpoint_t *cp)
+{
+    checkpoint_record_t record = {
+        .magic = CHECKPOINT_MAGIC,
+        .version = CHECKPOINT_VERSION,
+        .size = sizeof(record),
+        .sequence = cp->sequence + 1,
+        .state = cp->state,
+    };
+    record.crc32 = crc32_update(0, &record, offsetof(checkpoint_record_t, crc32));
+
+    // alternate slots so the previous record stays intact until this one is on the card
+    int slot = record.sequence % 2;
+    if (fseek(cp->file, (long)slot * CHECKPOINT_SLOT_SIZE, SEEK_SET) != 0
+        || fwrite(&record, sizeof(record), 1, cp->file) != 1
+        || fflush(cp->file) != 0
+        || fsync(fileno(cp->file)) != 0)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to write checkpoint #%lu", (unsigned long)record.sequence);
+        return ESP_FAIL;
+    }
+    cp->sequence = record.sequence;
+
+    return ESP_OK;
+}
+
+void checkpoint_close(checkpoint_t *cp)
+{
+    if (cp->file != NULL)
+    {
+        fclose(cp->file);
+        cp->file = NULL;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Persisted resume point
+ *
+ * The checkpoint file holds two fixed size slots, each in its own FAT sector.
+ * Saves alternate between the slots and carry an increasing sequence number
+ * and a CRC, so a write torn by a power cut can only ever damage the slot
+ * being written; loading picks the newest slot that checks out.
+ */
+
+#define CHECKPOINT_SLOT_SIZE   4096    // matches CONFIG_FATFS_SECTOR_4096
+
+typedef struct {
+    uint32_t dict_count;            // identifies the dictionary chain the indices refer to
+    uint32_t dict_crc32;
+    uint32_t dict_index;            // chain index of the next passcode to try
+    uint32_t dict_offset;           // byte offset of that passcode in its dictionary file
+    uint32_t schedule_attempts;     // schedule state
+    uint32_t schedule_window_attempts;
+    int64_t schedule_lockout_us;    // timeout in progress when the checkpoint was taken
+} checkpoint_state_t;
+
+typedef struct {
+    FILE *file;
+    uint32_t sequence;              // sequence number of the newest record, 0 if none yet
+    checkpoint_state_t state;
+} checkpoint_t;
+
+// open (creating if needed) the checkpoint file and load the newest valid record.
+// On success cp->sequence is 0 if there was nothing to resume from
+esp_err_t checkpoint_open(checkpoint_t *cp, const char *path);
+
+// durably write cp->state into the older of the two slots
+esp_err_t checkpoint_save(checkpoint_t *cp);
+
+void checkpoint_close(checkpoint_t *cp);
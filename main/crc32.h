@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Standard (IEEE 802.3, reflected) CRC32
+ *
+ * Pass 0 as the initial crc and feed the previous result back in to
+ * checksum data in several pieces. Matches zlib's crc32(). On the device
+ * this is the ROM implementation, so it is cheap enough for every block read.
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
@@ -0,0 +1,284 @@
+#include <string.h>
+#include "esp_log.h"
+#include "crc32.h"
+#include "dict.h"
+
+#define LOG_TAG                "dict"
+
+// byte offset just past the last entry, or for a compressed dictionary past the last block's data
+static esp_err_t dict_end(dict_t *dict, uint32_t *end)
+{
+    if (dict->entry_size != 0 || dict->count == 0)
+    {
+        *end = dict->entry_size != 0 ? dict_offset(dict, dict->count) : DICT_HEADER_SIZE;
+        return ESP_OK;
+    }
+
+    uint32_t blocks = dict_block_count(dict->count);
+    dict_block_info_t info;
+    if (block_reader_read(&dict->reader, DICT_HEADER_SIZE + (blocks - 1) * DICT_BLOCK_INFO_SIZE,
+                          &info, sizeof(info)) != ESP_OK)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t last_count = dict->count - (blocks - 1) * DICT_BLOCK_ENTRIES;
+    *end = DICT_HEADER_SIZE + blocks * DICT_BLOCK_INFO_SIZE + dict_block_data_offset(&info)
+         + (last_count * dict_block_bits(&info) + 7) / 8;
+    return ESP_OK;
+}
+
+// check the header's CRC32 over everything from the end of the header to `end`, for dictionaries
+// without per-block CRCs. Reads the whole dictionary once, a few seconds for PIN6 from the card
+static esp_err_t dict_verify_entries(dict_t *dict, uint32_t end)
+{
+    uint32_t crc = 0;
+    uint32_t offset = DICT_HEADER_SIZE;
+    while (offset < end)
+    {
+        size_t length;
+        const uint8_t *block = block_reader_get(&dict->reader, offset / BLOCK_READER_BLOCK_SIZE, &length);
+        size_t within = offset % BLOCK_READER_BLOCK_SIZE;
+        if (block == NULL || within >= length)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        size_t chunk = length - within < end - offset ? length - within : end - offset;
+        crc = crc32_update(crc, block + within, chunk);
+        offset += chunk;
+    }
+    return crc == dict->crc32 ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+// validate the header of the dictionary behind dict->reader, `name` is for messages
+static esp_err_t dict_load_header(dict_t *dict, const char *name)
+{
+    dict_header_t header;
+    if (block_reader_read(&dict->reader, 0, &header, sizeof(header)) != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "%s: truncated header", name);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (memcmp(header.magic, DICT_MAGIC, sizeof(header.magic)) != 0
+        || (header.version != DICT_VERSION && header.version != DICT_VERSION_COMPRESSED))
+    {
+        ESP_LOGE(LOG_TAG, "%s: not a packed dictionary (version %d)", name, header.version);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    // a flag this firmware does not know changes the layout in a way it cannot read
+    if ((header.flags & ~DICT_FLAGS_KNOWN) != 0)
+    {
+        ESP_LOGE(LOG_TAG, "%s: unsupported flags 0x%02x", name, header.flags);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    uint8_t entry_size = header.version == DICT_VERSION_COMPRESSED ? 0 : dict_entry_size_for_digits(header.digits);
+    if (header.digits == 0 || header.digits > DICT_MAX_DIGITS || header.entry_size != entry_size)
+    {
+        ESP_LOGE(LOG_TAG, "%s: bad geometry (%d digits, %d byte entries)", name, header.digits, header.entry_size);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dict->digits = header.digits;
+    dict->entry_size = header.entry_size;
+    dict->count = header.count;
+    dict->crc32 = header.crc32;
+    dict->index = 0;
+    dict->info_first = UINT32_MAX;
+    dict->info_count = 0;
+
+    // the entries, or for a compressed dictionary the block table, must all be there
+    uint32_t end = entry_size == 0
+        ? DICT_HEADER_SIZE + dict_block_count(dict->count) * DICT_BLOCK_INFO_SIZE
+        : dict_offset(dict, dict->count);
+    if (end > dict->reader.size)
+    {
+        ESP_LOGE(LOG_TAG, "%s: truncated, expected %lu entries", name, (unsigned long)dict->count);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if ((header.flags & DICT_FLAG_BLOCK_CRC) != 0)
+    {
+        // from here on every block is checked as it is read; the header was read before that, so check it again
+        dict_header_t checked;
+        if (dict_end(dict, &end) != ESP_OK
+            || block_reader_verify_blocks(&dict->reader, end) != ESP_OK
+            || block_reader_read(&dict->reader, 0, &checked, sizeof(checked)) != ESP_OK
+            || memcmp(&checked, &header, sizeof(header)) != 0)
+        {
+            ESP_LOGE(LOG_TAG, "%s: corrupt", name);
+            return ESP_ERR_INVALID_CRC;
+        }
+    }
+    else
+    {
+        // nothing checks the blocks as they are read, so check the whole dictionary now
+        esp_err_t ret = dict_end(dict, &end);
+        if (ret == ESP_OK)
+        {
+            ret = dict_verify_entries(dict, end);
+        }
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(LOG_TAG, "%s: %s", name, ret == ESP_ERR_INVALID_CRC ? "entries fail their CRC" : "truncated");
+            return ret == ESP_ERR_INVALID_CRC ? ESP_ERR_INVALID_CRC : ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t dict_open(dict_t *dict, const char *path)
+{
+    memset(dict, 0, sizeof(*dict));
+
+    esp_err_t ret = block_reader_open(&dict->reader, path);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open %s", path);
+        return ret;
+    }
+
+    ret = dict_load_header(dict, path);
+    if (ret != ESP_OK)
+    {
+        dict_close(dict);
+    }
+    return ret;
+}
+
+esp_err_t dict_open_memory(dict_t *dict, const void *data, uint32_t size, const char *name)
+{
+    memset(dict, 0, sizeof(*dict));
+    block_reader_open_memory(&dict->reader, data, size);
+
+    esp_err_t ret = dict_load_header(dict, name);
+    if (ret != ESP_OK)
+    {
+        dict_close(dict);
+    }
+    return ret;
+}
+
+void dict_close(dict_t *dict)
+{
+    block_reader_close(&dict->reader);
+}
+
+esp_err_t dict_seek(dict_t *dict, uint32_t index)
+{
+    if (index > dict->count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    dict->index = index;
+
+    return ESP_OK;
+}
+
+// decode entry dict->index of a compressed dictionary, loading the infos around its block when it
+// is not among the cached ones
+static esp_err_t dict_decode(dict_t *dict, uint32_t *value)
+{
+    uint32_t block = dict->index / DICT_BLOCK_ENTRIES;
+    if (block - dict->info_first >= dict->info_count)
+    {
+        uint32_t first = block - block % DICT_INFO_CACHE_BLOCKS;
+        uint32_t blocks = dict_block_count(dict->count) - first;
+        uint32_t count = blocks < DICT_INFO_CACHE_BLOCKS ? blocks : DICT_INFO_CACHE_BLOCKS;
+        dict->info_count = 0;
+        if (block_reader_read(&dict->reader, DICT_HEADER_SIZE + first * DICT_BLOCK_INFO_SIZE,
+                              dict->block_infos, count * DICT_BLOCK_INFO_SIZE) != ESP_OK)
+        {
+            return ESP_FAIL;
+        }
+        dict->info_first = first;
+        dict->info_count = count;
+    }
+    const dict_block_info_t *info = &dict->block_infos[block - dict->info_first];
+
+    // the entry's bits, least significant first, span at most five bytes
+    uint8_t bits = dict_block_bits(info);
+    uint32_t delta = 0;
+    if (bits > 0)
+    {
+        uint32_t bit = (dict->index % DICT_BLOCK_ENTRIES) * bits;
+        uint32_t offset = DICT_HEADER_SIZE + dict_block_count(dict->count) * DICT_BLOCK_INFO_SIZE
+                        + dict_block_data_offset(info) + bit / 8;
+        uint8_t bytes[5];
+        size_t length = (bit % 8 + bits + 7) / 8;
+        if (block_reader_read(&dict->reader, offset, bytes, length) != ESP_OK)
+        {
+            return ESP_FAIL;
+        }
+        uint64_t window = 0;
+        for (int i = length - 1; i >= 0; i--)
+        {
+            window = (window << 8) | bytes[i];
+        }
+        delta = (window >> (bit % 8)) & ((1ULL << bits) - 1);
+    }
+    *value = info->base + delta;
+
+    return ESP_OK;
+}
+
+esp_err_t dict_next(dict_t *dict, candidate_t *candidate)
+{
+    if (dict->index >= dict->count)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (dict->entry_size == 0)
+    {
+        if (dict_decode(dict, &candidate->value) != ESP_OK)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to read entry %lu", (unsigned long)dict->index);
+            return ESP_FAIL;
+        }
+        candidate->digits = dict->digits;
+        dict->index++;
+        return ESP_OK;
+    }
+
+    // entries may straddle a block boundary, block_reader_read() takes care of that
+    uint8_t entry[4];
+    if (block_reader_read(&dict->reader, dict_offset(dict, dict->index), entry, dict->entry_size) != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to read entry %lu", (unsigned long)dict->index);
+        return ESP_FAIL;
+    }
+    candidate->value = dict_entry_decode(entry, dict->entry_size);
+    candidate->digits = dict->digits;
+    dict->index++;
+
+    return ESP_OK;
+}
+
+esp_err_t dict_prefetch(dict_t *dict)
+{
+    return block_reader_prefetch(&dict->reader);
+}
+
+esp_err_t dict_find(dict_t *dict, uint32_t value, uint32_t *index)
+{
+    esp_err_t ret = dict_seek(dict, 0);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    candidate_t candidate;
+    while ((ret = dict_next(dict, &candidate)) == ESP_OK)
+    {
+        if (candidate.value == value)
+        {
+            *index = dict->index - 1;
+            return dict_seek(dict, *index);
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "dict_format.h"
+#include "candidate.h"
+#include "block_reader.h"
+
+/**
+ * @brief Reader for packed and compressed passcode dictionaries (see dict_format.h)
+ *
+ * The block infos of a compressed dictionary are loaded DICT_INFO_CACHE_BLOCKS
+ * at a time into the dict itself, so the block reader's two buffers are left
+ * to the entry data and a prefetch is not undone by the next block change.
+ */
+
+#define DICT_INFO_CACHE_BLOCKS 64      // block infos loaded at once, 512 bytes covering 4096 entries
+
+typedef struct {
+    block_reader_t reader;
+    uint8_t digits;         // length of every candidate in the dictionary
+    uint8_t entry_size;     // bytes per packed entry, 0 for a compressed dictionary
+    uint32_t count;         // number of candidates
+    uint32_t crc32;         // checksum from the header, identifies the dictionary contents
+    uint32_t index;         // index of the entry dict_next() returns next
+    uint32_t info_first;    // first compressed block in block_infos, UINT32_MAX if none
+    uint32_t info_count;    // blocks in block_infos
+    dict_block_info_t block_infos[DICT_INFO_CACHE_BLOCKS];
+} dict_t;
+
+// open a packed dictionary and validate its header, positioned at entry 0
+esp_err_t dict_open(dict_t *dict, const char *path);
+
+// open a packed dictionary that is already in memory, e.g. a mapped flash partition.
+// `name` only appears in error messages
+esp_err_t dict_open_memory(dict_t *dict, const void *data, uint32_t size, const char *name);
+
+void dict_close(dict_t *dict);
+
+// position the reader so that the next dict_next() returns entry `index`
+esp_err_t dict_seek(dict_t *dict, uint32_t index);
+
+// byte offset within the dictionary file that reading entry `index` starts from: the entry itself,
+// or for a compressed dictionary the info of the block holding it
+static inline uint32_t dict_offset(const dict_t *dict, uint32_t index)
+{
+    if (dict->entry_size == 0)
+    {
+        return DICT_HEADER_SIZE + index / DICT_BLOCK_ENTRIES * DICT_BLOCK_INFO_SIZE;
+    }
+    return DICT_HEADER_SIZE + index * dict->entry_size;
+}
+
+// read the next candidate, returns ESP_ERR_NOT_FOUND once every entry has been read
+esp_err_t dict_next(dict_t *dict, candidate_t *candidate);
+
+// load the block after the one being consumed, call while otherwise idle
+esp_err_t dict_prefetch(dict_t *dict);
+
+// index of the first entry equal to `value`, leaving the reader positioned on it.
+// Returns ESP_ERR_NOT_FOUND if absent
+esp_err_t dict_find(dict_t *dict, uint32_t value, uint32_t *index);
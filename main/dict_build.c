@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "dict_build.h"
+#include "dict_format.h"
+#include "text_tokenizer.h"
+#include "crc32.h"
+#include "block_reader.h"
+
+#define LOG_TAG                "dict_build"
+#define DICT_BUILD_PATH_MAX    256
+
+// next candidate from the text, checking it has the same length as the ones before.
+// Returns ESP_ERR_NOT_FOUND once the whole text has been read
+static esp_err_t dict_build_next(text_tokenizer_t *tok, const char *text_path, uint8_t *digits, candidate_t *candidate)
+{
+    esp_err_t ret = text_tokenizer_next(tok, candidate);
+    if (ret == ESP_ERR_INVALID_ARG)
+    {
+        ESP_LOGE(LOG_TAG, "%s:%lu: not a passcode", text_path, (unsigned long)tok->line);
+        return ret;
+    }
+    if (ret == ESP_ERR_INVALID_SIZE)
+    {
+        ESP_LOGE(LOG_TAG, "%s:%lu: passcodes longer than %d digits are not supported",
+                 text_path, (unsigned long)tok->line, DICT_MAX_DIGITS);
+        return ret;
+    }
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    if (*digits == 0)
+    {
+        *digits = candidate->digits;
+    }
+    else if (candidate->digits != *digits)
+    {
+        ESP_LOGE(LOG_TAG, "%s:%lu: passcode is %d digits long, expected %d",
+                 text_path, (unsigned long)tok->line, candidate->digits, *digits);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+// fixed width entries, written as they are read
+static esp_err_t dict_build_packed(const char *text_path, FILE *out, dict_header_t *header)
+{
+    text_tokenizer_t tok;
+    esp_err_t ret = text_tokenizer_open(&tok, text_path);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open %s", text_path);
+        return ret;
+    }
+
+    candidate_t candidate;
+    while ((ret = dict_build_next(&tok, text_path, &header->digits, &candidate)) == ESP_OK)
+    {
+        header->entry_size = dict_entry_size_for_digits(header->digits);
+        uint8_t entry[4];
+        dict_entry_encode(entry, header->entry_size, candidate.value);
+        fwrite(entry, header->entry_size, 1, out);
+        header->crc32 = crc32_update(header->crc32, entry, header->entry_size);
+        header->count++;
+    }
+    text_tokenizer_close(&tok);
+
+    // ESP_ERR_NOT_FOUND means the whole text was read
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+        header->version = DICT_VERSION;
+        ret = ESP_OK;
+    }
+    return ret;
+}
+
+// bit pack one block of values as differences from the smallest
+static void dict_build_block(const uint32_t *values, uint32_t count, dict_block_info_t *info,
+                             uint8_t *data, size_t *length)
+{
+    uint32_t base = values[0];
+    uint32_t top = values[0];
+    for (uint32_t i = 1; i < count; i++)
+    {
+        base = values[i] < base ? values[i] : base;
+        top = values[i] > top ? values[i] : top;
+    }
+    uint8_t bits = 0;
+    while (bits < 32 && (top - base) >> bits != 0)
+    {
+        bits++;
+    }
+
+    *length = (count * bits + 7) / 8;
+    memset(data, 0, *length);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bit = i * bits;
+        uint64_t window = (uint64_t)(values[i] - base) << (bit % 8);
+        for (uint32_t byte = bit / 8; window != 0; byte++)
+        {
+            data[byte] |= window & 0xFF;
+            window >>= 8;
+        }
+    }
+
+    info->base = base;
+    info->position = bits;
+}
+
+// frame-of-reference blocks. The block table comes first, so the text is read twice: once to count
+// the entries, once to encode them. Memory use does not depend on the size of the dictionary
+static esp_err_t dict_build_compressed(const char *text_path, FILE *out, dict_header_t *header)
+{
+    text_tokenizer_t tok;
+    esp_err_t ret = text_tokenizer_open(&tok, text_path);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open %s", text_path);
+        return ret;
+    }
+    candidate_t candidate;
+    while ((ret = dict_build_next(&tok, text_path, &header->digits, &candidate)) == ESP_OK)
+    {
+        header->count++;
+    }
+    text_tokenizer_close(&tok);
+    if (ret != ESP_ERR_NOT_FOUND)
+    {
+        return ret;
+    }
+
+    ret = text_tokenizer_open(&tok, text_path);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    uint32_t blocks = dict_block_count(header->count);
+    uint32_t data_start = DICT_HEADER_SIZE + blocks * DICT_BLOCK_INFO_SIZE;
+    uint32_t data_offset = 0;
+    for (uint32_t block = 0; block < blocks && ret == ESP_OK; block++)
+    {
+        uint32_t values[DICT_BLOCK_ENTRIES] = {0};
+        uint32_t count = header->count - block * DICT_BLOCK_ENTRIES;
+        count = count < DICT_BLOCK_ENTRIES ? count : DICT_BLOCK_ENTRIES;
+        for (uint32_t i = 0; i < count && ret == ESP_OK; i++)
+        {
+            ret = dict_build_next(&tok, text_path, &header->digits, &candidate);
+            values[i] = candidate.value;
+        }
+        if (ret != ESP_OK)
+        {
+            break;
+        }
+
+        if (data_offset >= 1UL << 27)
+        {
+            ESP_LOGE(LOG_TAG, "%s: too big to compress", text_path);
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+
+        dict_block_info_t info;
+        uint8_t data[DICT_BLOCK_ENTRIES * 4];
+        size_t length;
+        dict_build_block(values, count, &info, data, &length);
+        info.position |= data_offset << 5;
+
+        fseek(out, DICT_HEADER_SIZE + block * DICT_BLOCK_INFO_SIZE, SEEK_SET);
+        fwrite(&info, sizeof(info), 1, out);
+        fseek(out, data_start + data_offset, SEEK_SET);
+        fwrite(data, length, 1, out);
+        data_offset += length;
+    }
+    text_tokenizer_close(&tok);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    // checksum the table and data as they ended up in the file
+    uint8_t buffer[512];
+    size_t length;
+    fflush(out);
+    fseek(out, DICT_HEADER_SIZE, SEEK_SET);
+    while ((length = fread(buffer, 1, sizeof(buffer), out)) > 0)
+    {
+        header->crc32 = crc32_update(header->crc32, buffer, length);
+    }
+    header->version = DICT_VERSION_COMPRESSED;
+    header->entry_size = 0;
+
+    return ESP_OK;
+}
+
+// append the CRC32 of every reader block of the finished file, see DICT_FLAG_BLOCK_CRC
+static void dict_build_block_crcs(FILE *out)
+{
+    fflush(out);
+    fseek(out, 0, SEEK_END);
+    uint32_t size = ftell(out);
+    uint32_t blocks = block_reader_blocks_for(size);
+    for (uint32_t block = 0; block < blocks; block++)
+    {
+        uint8_t buffer[512];
+        uint32_t crc = 0;
+        uint32_t remaining = size - block * BLOCK_READER_BLOCK_SIZE;
+        remaining = remaining < BLOCK_READER_BLOCK_SIZE ? remaining : BLOCK_READER_BLOCK_SIZE;
+        fseek(out, block * BLOCK_READER_BLOCK_SIZE, SEEK_SET);
+        while (remaining > 0)
+        {
+            size_t length = fread(buffer, 1, remaining < sizeof(buffer) ? remaining : sizeof(buffer), out);
+            if (length == 0)
+            {
+                break;
+            }
+            crc = crc32_update(crc, buffer, length);
+            remaining -= length;
+        }
+        fseek(out, size + block * sizeof(crc), SEEK_SET);
+        fwrite(&crc, sizeof(crc), 1, out);
+    }
+}
+
+esp_err_t dict_build(const char *text_path, const char *dict_path, bool compressed)
+{
+    FILE *out = fopen(dict_path, "w+b");
+    if (out == NULL)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to create %s", dict_path);
+        return ESP_FAIL;
+    }
+
+    // placeholder without a magic, rewritten once the entry count and checksum are known
+    dict_header_t header = {0};
+    fwrite(&header, sizeof(header), 1, out);
+
+    esp_err_t ret = compressed
+        ? dict_build_compressed(text_path, out, &header)
+        : dict_build_packed(text_path, out, &header);
+    if (ret == ESP_OK)
+    {
+        memcpy(header.magic, DICT_MAGIC, sizeof(header.magic));
+        header.flags = DICT_FLAG_BLOCK_CRC;
+        fseek(out, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, out);
+        dict_build_block_crcs(out);
+        ret = ferror(out) ? ESP_FAIL : ESP_OK;
+    }
+
+    if (fclose(out) != 0 && ret == ESP_OK)
+    {
+        ret = ESP_FAIL;
+    }
+    if (ret != ESP_OK)
+    {
+        remove(dict_path);
+        return ret;
+    }
+
+    ESP_LOGI(LOG_TAG, "%s: %lu passcodes of %d digits", dict_path, (unsigned long)header.count, header.digits);
+    return ESP_OK;
+}
+
+esp_err_t dict_open_or_build(dict_t *dict, const char *path)
+{
+    size_t length = strlen(path);
+    if (length < 4 || strcasecmp(path + length - 4, ".TXT") != 0)
+    {
+        return dict_open(dict, path);
+    }
+
+    char packed_path[DICT_BUILD_PATH_MAX];
+    if (length >= sizeof(packed_path))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(packed_path, path, length - 4);
+    strcpy(packed_path + length - 4, ".DIC");
+
+    struct stat st;
+    if (stat(packed_path, &st) == 0 && dict_open(dict, packed_path) == ESP_OK)
+    {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(LOG_TAG, "Packing %s into %s", path, packed_path);
+    esp_err_t ret = dict_build(path, packed_path, false);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return dict_open(dict, packed_path);
+}
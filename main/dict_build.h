@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dict.h"
+
+/**
+ * @brief Text to packed dictionary conversion
+ *
+ * Shared by tools/pin2dict on the host and the firmware, which packs a text
+ * dictionary on the card the first time it is selected. The text is read
+ * with the streaming tokenizer; every candidate must have the same length.
+ */
+
+// pack the text dictionary at `text_path` into `dict_path`, fixed width or compressed. The header
+// is only written once every entry is, so a conversion cut short leaves a file dict_open() rejects
+esp_err_t dict_build(const char *text_path, const char *dict_path, bool compressed);
+
+// open the dictionary at `path`. A text dictionary (".TXT") is opened through its packed twin
+// (same name, ".DIC"), which is built first if it is missing or unreadable
+esp_err_t dict_open_or_build(dict_t *dict, const char *path);
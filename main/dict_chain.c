@@ -0,0 +1,247 @@
+#include <string.h>
+#include "esp_log.h"
+#include "dict_chain.h"
+#include "crc32.h"
+
+#define LOG_TAG                "dict_chain"
+#define DICT_CHAIN_NAME_MAX    64
+
+static uint32_t dict_chain_keyspace_size(uint8_t digits)
+{
+    uint32_t size = 1;
+    for (int i = 0; i < digits; i++)
+    {
+        size *= 10;
+    }
+    return size;
+}
+
+esp_err_t dict_chain_open(dict_chain_t *chain, const char *names, dict_chain_open_fn open)
+{
+    memset(chain, 0, sizeof(*chain));
+
+    const char *name = names;
+    while (*name != '\0')
+    {
+        // next name, without the separator and any spaces around it
+        const char *end = strchr(name, DICT_CHAIN_SEPARATOR);
+        size_t length = end != NULL ? (size_t)(end - name) : strlen(name);
+        while (length > 0 && *name == ' ')
+        {
+            name++;
+            length--;
+        }
+        while (length > 0 && name[length - 1] == ' ')
+        {
+            length--;
+        }
+
+        if (length > 0)
+        {
+            char single[DICT_CHAIN_NAME_MAX];
+            if (chain->length == DICT_CHAIN_MAX || length >= sizeof(single))
+            {
+                ESP_LOGE(LOG_TAG, "Too many dictionaries, or a name too long, in \"%s\"", names);
+                dict_chain_close(chain);
+                return ESP_ERR_INVALID_ARG;
+            }
+            memcpy(single, name, length);
+            single[length] = '\0';
+
+            dict_t *dict = &chain->dicts[chain->length];
+            esp_err_t ret = open(dict, single);
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to open dictionary %s", single);
+                dict_chain_close(chain);
+                return ret;
+            }
+            ESP_LOGI(LOG_TAG, "Dictionary %s has %lu passcodes of %d digits", single,
+                     (unsigned long)dict->count, dict->digits);
+
+            chain->first[chain->length] = chain->count;
+            chain->count += dict->count;
+            chain->lengths |= 1u << dict->digits;
+            chain->length++;
+        }
+
+        if (end == NULL)
+        {
+            break;
+        }
+        name = end + 1;
+    }
+
+    if (chain->length == 0)
+    {
+        ESP_LOGE(LOG_TAG, "No dictionary in \"%s\"", names);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // then whatever the dictionaries leave of their lengths' keyspaces, shortest first
+    chain->sources = chain->length;
+    chain->total = chain->count;
+    for (int digits = 1; digits <= VISITED_MAX_DIGITS; digits++)
+    {
+        if (chain->lengths & (1u << digits))
+        {
+            int keyspace = chain->sources - chain->length;
+            chain->keyspace_digits[keyspace] = digits;
+            chain->first[chain->sources] = chain->total;
+            chain->total += dict_chain_keyspace_size(digits);
+            chain->sources++;
+            ESP_LOGI(LOG_TAG, "Then the rest of the %d digit keyspace", digits);
+        }
+    }
+
+    // a chain of one keeps the dictionary's identity, longer ones are identified by all of theirs in order.
+    // The keyspaces follow from the dictionaries, so they need no part in it
+    chain->crc32 = chain->dicts[0].crc32;
+    if (chain->length > 1)
+    {
+        chain->crc32 = 0;
+        for (int i = 0; i < chain->length; i++)
+        {
+            chain->crc32 = crc32_update(chain->crc32, &chain->dicts[i].count, sizeof(chain->dicts[i].count));
+            chain->crc32 = crc32_update(chain->crc32, &chain->dicts[i].crc32, sizeof(chain->dicts[i].crc32));
+        }
+    }
+
+    return ESP_OK;
+}
+
+void dict_chain_close(dict_chain_t *chain)
+{
+    for (int i = 0; i < chain->length; i++)
+    {
+        dict_close(&chain->dicts[i]);
+    }
+    chain->length = 0;
+}
+
+// source holding chain entry `index`, the last one for the index just past the end
+static int dict_chain_source(const dict_chain_t *chain, uint32_t index)
+{
+    int source = 0;
+    while (source + 1 < chain->sources && chain->first[source + 1] <= index)
+    {
+        source++;
+    }
+    return source;
+}
+
+esp_err_t dict_chain_seek(dict_chain_t *chain, uint32_t index)
+{
+    if (index > chain->total)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int source = dict_chain_source(chain, index);
+    uint32_t entry = index - chain->first[source];
+    esp_err_t ret = ESP_OK;
+    if (source < chain->length)
+    {
+        ret = dict_seek(&chain->dicts[source], entry);
+        entry = 0;
+    }
+    for (int i = source + 1; i < chain->length && ret == ESP_OK; i++)
+    {
+        ret = dict_seek(&chain->dicts[i], 0);
+    }
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    chain->current = source;
+    chain->keyspace_value = entry;
+    chain->index = index;
+    return ESP_OK;
+}
+
+uint32_t dict_chain_offset(const dict_chain_t *chain, uint32_t index)
+{
+    int source = dict_chain_source(chain, index);
+    if (source >= chain->length)
+    {
+        return index - chain->first[source];
+    }
+    return dict_offset(&chain->dicts[source], index - chain->first[source]);
+}
+
+// next entry of the current source, ESP_ERR_NOT_FOUND once it is exhausted
+static esp_err_t dict_chain_source_next(dict_chain_t *chain, candidate_t *candidate)
+{
+    if (chain->current < chain->length)
+    {
+        return dict_next(&chain->dicts[chain->current], candidate);
+    }
+
+    uint8_t digits = chain->keyspace_digits[chain->current - chain->length];
+    if (chain->keyspace_value == dict_chain_keyspace_size(digits))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    candidate->value = chain->keyspace_value++;
+    candidate->digits = digits;
+    return ESP_OK;
+}
+
+esp_err_t dict_chain_next(dict_chain_t *chain, uint32_t *index, candidate_t *candidate)
+{
+    while (chain->current < chain->sources)
+    {
+        esp_err_t ret = dict_chain_source_next(chain, candidate);
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            chain->current++;
+            chain->keyspace_value = 0;
+            continue;
+        }
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+
+        uint32_t entry = chain->index++;
+        if (chain->visited != NULL && visited_test(chain->visited, candidate))
+        {
+            chain->skipped++;
+            continue;
+        }
+        *index = entry;
+        return ESP_OK;
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t dict_chain_prefetch(dict_chain_t *chain)
+{
+    if (chain->current >= chain->length)
+    {
+        return ESP_OK;
+    }
+    return dict_prefetch(&chain->dicts[chain->current]);
+}
+
+esp_err_t dict_chain_find(dict_chain_t *chain, uint32_t value, uint32_t *index)
+{
+    for (int i = 0; i < chain->length; i++)
+    {
+        uint32_t entry;
+        esp_err_t ret = dict_find(&chain->dicts[i], value, &entry);
+        if (ret == ESP_OK)
+        {
+            *index = chain->first[i] + entry;
+            return ESP_OK;
+        }
+        if (ret != ESP_ERR_NOT_FOUND)
+        {
+            return ret;
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
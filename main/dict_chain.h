@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "candidate.h"
+#include "dict.h"
+#include "visited.h"
+
+/**
+ * @brief Several dictionaries tried one after the other
+ *
+ * The chain numbers its entries straight through, dictionary after
+ * dictionary, so the engine, journal and checkpoint see one long list. A
+ * chain of one dictionary has that dictionary's count and CRC, so single
+ * dictionary runs resume from their existing checkpoints. Entries already
+ * in the visited set are skipped while reading, so a passcode listed in
+ * more than one dictionary (or tried in an earlier run) is only typed once.
+ */
+
+#define DICT_CHAIN_MAX         4       // dictionaries in a chain
+#define DICT_CHAIN_SEPARATOR   ','     // between the names in a chain setting
+#define DICT_CHAIN_MAX_SOURCES (DICT_CHAIN_MAX + VISITED_MAX_DIGITS)   // dictionaries and keyspaces
+
+// opens dictionary `name`, one of the names in the chain setting
+typedef esp_err_t (*dict_chain_open_fn)(dict_t *dict, const char *name);
+
+typedef struct {
+    dict_t dicts[DICT_CHAIN_MAX];
+    uint8_t keyspace_digits[VISITED_MAX_DIGITS];    // length each keyspace after the dictionaries counts through
+    uint32_t first[DICT_CHAIN_MAX_SOURCES];         // chain index of each source's entry 0, dictionaries first
+    uint8_t length;                     // dictionaries in the chain
+    uint8_t sources;                    // dictionaries and keyspaces in the chain
+    uint8_t current;                    // source dict_chain_next() reads from
+    uint32_t keyspace_value;            // value the keyspace being read generates next
+    uint32_t count;                     // entries in all the dictionaries, identifies the chain with crc32
+    uint32_t crc32;                     // the dictionary's own CRC for a chain of one
+    uint32_t total;                     // entries in the dictionaries and the keyspaces
+    uint32_t index;                     // chain index of the entry dict_chain_next() reads next
+    uint32_t lengths;                   // passcode lengths in the chain, bit N set for N digits
+    const visited_t *visited;           // passcodes to skip, NULL to read everything
+    uint32_t skipped;                   // entries skipped as already visited
+} dict_chain_t;
+
+// open the dictionaries named in `names`, separated by DICT_CHAIN_SEPARATOR, and follow them with
+// their lengths' keyspaces, positioned at entry 0
+esp_err_t dict_chain_open(dict_chain_t *chain, const char *names, dict_chain_open_fn open);
+
+void dict_chain_close(dict_chain_t *chain);
+
+// position the chain so that the next dict_chain_next() reads entry `index`
+esp_err_t dict_chain_seek(dict_chain_t *chain, uint32_t index);
+
+// byte offset of entry `index` within its own dictionary file (see dict_offset()), or its value
+// for a keyspace entry
+uint32_t dict_chain_offset(const dict_chain_t *chain, uint32_t index);
+
+// read the next candidate not yet visited and its chain index, ESP_ERR_NOT_FOUND once the last
+// keyspace is exhausted
+esp_err_t dict_chain_next(dict_chain_t *chain, uint32_t *index, candidate_t *candidate);
+
+// load the next block of the dictionary being read, call while otherwise idle
+esp_err_t dict_chain_prefetch(dict_chain_t *chain);
+
+// chain index of the first dictionary entry equal to `value`, ESP_ERR_NOT_FOUND if in none of them.
+// Leaves the chain to be repositioned with dict_chain_seek()
+esp_err_t dict_chain_find(dict_chain_t *chain, uint32_t value, uint32_t *index);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Packed passcode dictionary on-disk format
+ *
+ * A packed dictionary is a 16 byte header followed by `count` fixed width
+ * entries. Each entry holds the numeric value of a candidate, little-endian,
+ * in `entry_size` bytes. The candidate length lives in the header so leading
+ * zeros survive the round trip ("0007" is stored as 7 with digits = 4).
+ *
+ * Because every entry has the same width, entry N lives at
+ * DICT_HEADER_SIZE + N * entry_size and can be read without touching the
+ * entries before it.
+ *
+ * Compressed dictionaries (DICT_VERSION_COMPRESSED, entry_size 0) keep the
+ * entries in rank order but bit pack them in blocks of DICT_BLOCK_ENTRIES
+ * using frame-of-reference coding: each block stores its smallest value and
+ * every entry as the difference from it in just enough bits for the largest
+ * difference. The header is followed by a table with one dict_block_info_t
+ * per block, then the block data; the CRC covers both. Entry N is found by
+ * reading the info for block N / DICT_BLOCK_ENTRIES and a few bytes of its
+ * data, so decoding needs no more memory than the plain format.
+ *
+ * With DICT_FLAG_BLOCK_CRC set, either format is followed by a table with the
+ * CRC32 of every BLOCK_READER_BLOCK_SIZE block of the file before it, header
+ * included, so each block read from the card is checked on its own as it
+ * streams in rather than the whole file up front. The table is not counted
+ * in the entry CRC, and anything after it (e.g. the rest of a flash
+ * partition) is ignored. Without the flag the entry CRC is checked over the
+ * whole dictionary when it is opened.
+ */
+
+#define DICT_MAGIC             "RRDC"
+#define DICT_VERSION           1
+#define DICT_VERSION_COMPRESSED 2
+#define DICT_HEADER_SIZE       16
+#define DICT_MAX_DIGITS        9
+#define DICT_BLOCK_ENTRIES     64
+#define DICT_BLOCK_INFO_SIZE   8
+#define DICT_FLAG_BLOCK_CRC    0x01    // a table of per-block CRC32s follows the dictionary
+#define DICT_FLAGS_KNOWN       DICT_FLAG_BLOCK_CRC
+
+typedef struct {
+    char magic[4];          // DICT_MAGIC, not NUL terminated
+    uint8_t version;        // DICT_VERSION
+    uint8_t digits;         // number of digits in every candidate
+    uint8_t entry_size;     // bytes per entry
+    uint8_t flags;          // DICT_FLAG_*, other bits must be zero
+    uint32_t count;         // number of entries following the header
+    uint32_t crc32;         // CRC32 of all entry bytes
+} dict_header_t;
+
+_Static_assert(sizeof(dict_header_t) == DICT_HEADER_SIZE, "dictionary header must be 16 bytes");
+
+typedef struct {
+    uint32_t base;          // smallest value in the block
+    uint32_t position;      // byte offset of the block data from the end of the table << 5 | bits per entry
+} dict_block_info_t;
+
+_Static_assert(sizeof(dict_block_info_t) == DICT_BLOCK_INFO_SIZE, "block info must be 8 bytes");
+
+static inline uint32_t dict_block_count(uint32_t count)
+{
+    return (count + DICT_BLOCK_ENTRIES - 1) / DICT_BLOCK_ENTRIES;
+}
+
+static inline uint32_t dict_block_data_offset(const dict_block_info_t *info)
+{
+    return info->position >> 5;
+}
+
+static inline uint8_t dict_block_bits(const dict_block_info_t *info)
+{
+    return info->position & 0x1F;
+}
+
+// smallest whole number of bytes able to hold any candidate of the given length
+static inline uint8_t dict_entry_size_for_digits(uint8_t digits)
+{
+    if (digits <= 4)
+    {
+        return 2;   // 9999 < 2^16
+    }
+    if (digits <= 7)
+    {
+        return 3;   // 9999999 < 2^24
+    }
+    return 4;
+}
+
+static inline uint32_t dict_entry_decode(const uint8_t *entry, uint8_t entry_size)
+{
+    uint32_t value = 0;
+    for (int i = entry_size - 1; i >= 0; i--)
+    {
+        value = (value << 8) | entry[i];
+    }
+    return value;
+}
+
+static inline void dict_entry_encode(uint8_t *entry, uint8_t entry_size, uint32_t value)
+{
+    for (int i = 0; i < entry_size; i++)
+    {
+        entry[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
@@ -0,0 +1,36 @@
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "dict_partition.h"
+
+#define LOG_TAG                "dict_partition"
+
+esp_err_t dict_open_partition(dict_t *dict, const char *label)
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == NULL)
+    {
+        ESP_LOGE(LOG_TAG, "No data partition labelled '%s'", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *data;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t ret = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &data, &handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to map partition '%s' (%s)", label, esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = dict_open_memory(dict, data, partition->size, label);
+    if (ret != ESP_OK)
+    {
+        esp_partition_munmap(handle);
+        return ret;
+    }
+    ESP_LOGI(LOG_TAG, "Mapped '%s' at 0x%08lx, %lu bytes", label,
+             (unsigned long)partition->address, (unsigned long)partition->size);
+
+    return ESP_OK;
+}
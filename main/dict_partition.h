@@ -0,0 +1,18 @@
+#pragma once
+
+#include "esp_err.h"
+#include "dict.h"
+
+/**
+ * @brief Packed dictionaries flashed into a data partition
+ *
+ * The partition is mapped through the flash cache and read with
+ * dict_open_memory(), so passcodes come out of plain memory reads and the SD
+ * card is only written to. The mapping is kept for the rest of the run.
+ */
+
+#define DICT_PARTITION_PREFIX  "partition:"     // dictionary=partition:<label> in RABBIT.CFG
+#define DICT_PARTITION_LABEL   "dict"           // the data partition in partitions.csv
+
+// map the data partition `label` and open the packed dictionary at its start
+esp_err_t dict_open_partition(dict_t *dict, const char *label);
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "engine.h"
+
+#define LOG_TAG                "engine"
+
+// Read last line of the legacy passcode log, written by firmware that predates the journal
+static esp_err_t read_last_passcode(const char *path, int *passcode)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    while (!feof(f))
+    {
+        if (fscanf(f, "%d", passcode) != 1)
+        {
+            break;
+        }
+    }
+
+    fclose(f);
+
+    return ESP_OK;
+}
+
+void engine_resume(engine_t *engine, dict_chain_t *chain, const checkpoint_t *checkpoint, const char *legacy_log_path)
+{
+    engine->chain_info = *chain;
+    engine->starting_index = 0;
+    engine->attempts_made = 0;
+    if (engine->schedule_rules == NULL)
+    {
+        engine->schedule_rules = schedule_default_rules;
+        engine->schedule_rule_count = schedule_default_rule_count;
+    }
+    schedule_init(&engine->schedule, engine->schedule_rules, engine->schedule_rule_count);
+
+    if (checkpoint->sequence != 0
+        && checkpoint->state.dict_count == chain->count
+        && checkpoint->state.dict_crc32 == chain->crc32
+        && checkpoint->state.dict_offset == dict_chain_offset(chain, checkpoint->state.dict_index))
+    {
+        engine->starting_index = checkpoint->state.dict_index;
+        schedule_restore(&engine->schedule, checkpoint->state.schedule_attempts,
+                         checkpoint->state.schedule_window_attempts, checkpoint->state.schedule_lockout_us,
+                         engine->clock->now_us(engine->clock->ctx));
+    }
+    else if (legacy_log_path != NULL)
+    {
+        // no usable checkpoint (first run, different dictionary or a run started by older firmware),
+        // fall back to the last tested passcode from the log file
+        int last_passcode = 0;
+        if (read_last_passcode(legacy_log_path, &last_passcode) == ESP_OK
+            && dict_chain_find(chain, last_passcode, &engine->starting_index) != ESP_OK)
+        {
+            ESP_LOGW(LOG_TAG, "Last passcode %d not in dictionary, starting from the top", last_passcode);
+            engine->starting_index = 0;
+        }
+    }
+
+    ESP_LOGI(LOG_TAG, "Previous attempts: %lu", (unsigned long)engine->starting_index);
+}
+
+// next passcode from the storage backend that has not been tried. The backend skips the ones
+// tried before it read them, this catches any it read ahead before they were tried
+static esp_err_t engine_next_passcode(engine_t *engine, uint32_t *index, candidate_t *passcode)
+{
+    const engine_storage_t *storage = engine->storage;
+    esp_err_t ret;
+    while ((ret = storage->next_passcode(storage->ctx, index, passcode)) == ESP_OK)
+    {
+        if (engine->visited == NULL || !visited_test(engine->visited, passcode))
+        {
+            return ESP_OK;
+        }
+    }
+    return ret;
+}
+
+static void engine_report(const engine_t *engine, uint32_t index, bool done)
+{
+    const engine_monitor_t *monitor = engine->monitor;
+    if (monitor == NULL)
+    {
+        return;
+    }
+
+    const engine_status_t status = {
+        .index = index,
+        .attempts_made = engine->attempts_made,
+        .schedule_attempts = engine->schedule.attempts,
+        .schedule_window_attempts = engine->schedule.window_attempts,
+        .lockout_us = engine->schedule.lockout_us,
+        .next_attempt_us = engine->schedule.next_attempt_us,
+        .durable_wait_us = engine->durable_wait_us,
+        .done = done,
+    };
+    monitor->report(monitor->ctx, &status);
+}
+
+// record progress so a reboot resumes with passcode `next_index` and the same schedule;
+// the backend writes the visited set back before the checkpoint
+static void engine_save_progress(const engine_t *engine, uint32_t next_index)
+{
+    const checkpoint_state_t progress = {
+        .dict_count = engine->chain_info.count,
+        .dict_crc32 = engine->chain_info.crc32,
+        .dict_index = next_index,
+        .dict_offset = dict_chain_offset(&engine->chain_info, next_index),
+        .schedule_attempts = engine->schedule.attempts,
+        .schedule_window_attempts = engine->schedule.window_attempts,
+        .schedule_lockout_us = engine->schedule.lockout_us,
+    };
+    engine->storage->save_checkpoint(engine->storage->ctx, &progress);
+}
+
+esp_err_t engine_run(engine_t *engine)
+{
+    const hid_sink_t *hid = engine->hid;
+    const engine_clock_t *clock = engine->clock;
+    const engine_storage_t *storage = engine->storage;
+
+    uint32_t passcode_index = 0;
+    candidate_t passcode;
+    esp_err_t next = engine_next_passcode(engine, &passcode_index, &passcode);
+    bool more_passcodes = next == ESP_OK;
+    if (more_passcodes)
+    {
+        hid->prepare(hid->ctx, &passcode);
+    }
+    engine_report(engine, more_passcodes ? passcode_index : engine->starting_index, next == ESP_ERR_NOT_FOUND);
+
+    // get cracking (observing timeouts etc)...
+    while (more_passcodes)
+    {
+        // sleep until the deadline set by the previous attempt (or a timeout still running from before a reboot),
+        // with the card powered down if the wait is a lockout
+        int64_t deadline_us = engine->schedule.next_attempt_us;
+        bool idle = storage->suspend != NULL
+            && deadline_us - clock->now_us(clock->ctx) >= ENGINE_IDLE_MIN_US;
+        if (idle)
+        {
+            storage->suspend(storage->ctx);
+            clock->sleep_until(clock->ctx, deadline_us - ENGINE_IDLE_WAKE_US);
+            storage->resume(storage->ctx);
+        }
+        clock->sleep_until(clock->ctx, deadline_us);
+        if (engine->monitor != NULL)
+        {
+            engine->monitor->wait_resumed(engine->monitor->ctx);
+        }
+        // a host that had gone away or suspended gets the schedule's grace period before the first keystroke
+        while (hid->wait_ready(hid->ctx))
+        {
+            clock->sleep_until(clock->ctx, schedule_link_restored(&engine->schedule, clock->now_us(clock->ctx)));
+        }
+
+        // journal the attempt before any key goes out
+        const journal_record_t record = {
+            .type = JOURNAL_RECORD_ATTEMPT,
+            .digits = passcode.digits,
+            .dict_index = passcode_index,
+            .passcode = passcode.value,
+        };
+        uint32_t ticket = storage->log_attempt(storage->ctx, &record);
+
+        // a passcode that did not go out whole is typed again once the link is back
+        if (hid->type_passcode(hid->ctx) != ESP_OK)
+        {
+            ESP_LOGW(LOG_TAG, "Passcode %lu not typed in full, trying it again", (unsigned long)passcode_index);
+            continue;
+        }
+
+        // make sure the attempt is on the card before it is submitted
+        int64_t typed_us = clock->now_us(clock->ctx);
+        esp_err_t durable = storage->wait_durable(storage->ctx, ticket);
+        engine->durable_wait_us = (uint32_t)(clock->now_us(clock->ctx) - typed_us);
+        if (durable != ESP_OK)
+        {
+            // an attempt the journal might not hold after a reset could spend a lockout window unrecorded
+            ESP_LOGE(LOG_TAG, "Attempt at %lu not on the card (error %d), stopping before Enter",
+                     (unsigned long)passcode_index, durable);
+            engine_report(engine, passcode_index, false);
+            return durable;
+        }
+        esp_err_t submitted = hid->submit(hid->ctx);
+        schedule_attempt_made(&engine->schedule, clock->now_us(clock->ctx));
+        if (submitted != ESP_OK)
+        {
+            // Enter may or may not have reached the target, so the attempt counts against the schedule
+            // and the retry never lands in a lockout, but the passcode is not taken as tried
+            ESP_LOGW(LOG_TAG, "Passcode %lu may not have been submitted, trying it again", (unsigned long)passcode_index);
+            engine_save_progress(engine, passcode_index);
+            continue;
+        }
+        engine->attempts_made++;
+        if (engine->visited != NULL)
+        {
+            visited_mark(engine->visited, &passcode);
+        }
+
+        uint32_t next_index = passcode_index + 1;
+        next = engine_next_passcode(engine, &passcode_index, &passcode);
+        more_passcodes = next == ESP_OK;
+        if (more_passcodes)
+        {
+            // ready to go out the moment the lockout ends
+            hid->prepare(hid->ctx, &passcode);
+        }
+
+        engine_save_progress(engine, next_index);
+        engine_report(engine, more_passcodes ? passcode_index : next_index, next == ESP_ERR_NOT_FOUND);
+    }
+
+    // a dictionary that cannot be read any further is not the end of the run, it needs fixing
+    if (next != ESP_ERR_NOT_FOUND)
+    {
+        ESP_LOGE(LOG_TAG, "Stopped, the next passcode could not be read (error %d)", next);
+        return next;
+    }
+    return ESP_OK;
+}
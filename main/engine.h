@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "candidate.h"
+#include "dict_chain.h"
+#include "checkpoint.h"
+#include "journal.h"
+#include "schedule.h"
+#include "visited.h"
+
+/**
+ * @brief Platform independent attempt engine
+ *
+ * Everything that decides what to type and when lives here; the firmware
+ * and the host simulator only differ in the HID sink, clock and storage
+ * backend they plug in.
+ */
+
+/**
+ * @brief Where keystrokes go (TinyUSB on the device, a mock target on the host)
+ */
+typedef struct {
+    void *ctx;
+    bool (*wait_ready)(void *ctx);                                  // block until keystrokes can be sent,
+                                                                    // true if the link was down meanwhile
+    void (*prepare)(void *ctx, const candidate_t *candidate);       // build the keystrokes for the next passcode
+    esp_err_t (*type_passcode)(void *ctx);                          // type the prepared passcode, again after a
+                                                                    // failure with what was typed cleared first
+    esp_err_t (*submit)(void *ctx);                                 // press Enter
+} hid_sink_t;
+
+/**
+ * @brief Time source (esp_timer on the device, a virtual clock on the host)
+ */
+typedef struct {
+    void *ctx;
+    int64_t (*now_us)(void *ctx);
+    void (*sleep_until)(void *ctx, int64_t deadline_us);
+} engine_clock_t;
+
+/**
+ * @brief Passcode source and persistence (storage task on the device, direct POSIX files on the host)
+ */
+typedef struct {
+    void *ctx;
+    esp_err_t (*next_passcode)(void *ctx, uint32_t *index, candidate_t *candidate);  // ESP_ERR_NOT_FOUND once
+                                                                                    // all are handed out
+    uint32_t (*log_attempt)(void *ctx, const journal_record_t *record);    // returns a durability ticket
+    esp_err_t (*wait_durable)(void *ctx, uint32_t ticket);         // ESP_OK once the attempt is on the card,
+                                                                    // nothing is submitted otherwise
+    void (*save_checkpoint)(void *ctx, const checkpoint_state_t *state);   // writes the visited set back first
+    void (*suspend)(void *ctx);         // sync and power the card down for a long wait, may be NULL
+    void (*resume)(void *ctx);          // power the card back up, may be NULL
+} engine_storage_t;
+
+/**
+ * @brief Progress of a run as reported to the monitor
+ */
+typedef struct {
+    uint32_t index;                     // chain index of the next passcode to try
+    uint32_t attempts_made;             // attempts submitted by this run
+    uint32_t schedule_attempts;
+    uint32_t schedule_window_attempts;
+    int64_t lockout_us;                 // timeout in progress, 0 if none
+    int64_t next_attempt_us;            // clock time the next attempt may go out
+    uint32_t durable_wait_us;           // time the last attempt waited for wait_durable()
+    bool done;                          // no passcodes left
+} engine_status_t;
+
+/**
+ * @brief Live view and remote control of a run (USB status channel on the device)
+ */
+typedef struct {
+    void *ctx;
+    void (*report)(void *ctx, const engine_status_t *status);      // on start, after every attempt and at the end
+    void (*wait_resumed)(void *ctx);                                // block while the run is paused
+} engine_monitor_t;
+
+#define ENGINE_IDLE_MIN_US     (60 * 1000000LL)    // waits at least this long suspend the storage backend
+#define ENGINE_IDLE_WAKE_US    500000              // resume storage this long before the deadline
+
+typedef struct {
+    const hid_sink_t *hid;
+    const engine_clock_t *clock;
+    const engine_storage_t *storage;
+    const engine_monitor_t *monitor;    // may be NULL
+    dict_chain_t chain_info;            // geometry and identity of the dictionaries, never read through
+    visited_t *visited;                 // passcodes already tried, marked as attempts go out; may be NULL
+    uint32_t starting_index;            // first chain entry this run tries
+    const schedule_rule_t *schedule_rules;  // target lockout policy, NULL for schedule_default_rules
+    size_t schedule_rule_count;
+    schedule_t schedule;
+    uint32_t attempts_made;             // attempts submitted by this run
+    uint32_t durable_wait_us;           // time the last attempt waited for its journal record
+} engine_t;
+
+// work out where to continue from: the checkpoint if it matches the dictionaries, otherwise the
+// last passcode in the legacy text log (may be NULL), otherwise the top of the chain
+void engine_resume(engine_t *engine, dict_chain_t *chain, const checkpoint_t *checkpoint, const char *legacy_log_path);
+
+// try every passcode the storage backend hands out and engine->visited does not hold, observing
+// the lockout schedule. Returns ESP_OK once they are all tried, the error that stopped the
+// backend from reading the next one, e.g. ESP_ERR_INVALID_CRC for a damaged dictionary block, or
+// the one that kept an attempt from being made durable, in which case it was never submitted
+esp_err_t engine_run(engine_t *engine);
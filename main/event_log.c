@@ -0,0 +1,105 @@
+#include <stdatomic.h>
+#include <sys/time.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spsc_queue.h"
+#include "event_log.h"
+
+#define LOG_TAG                "event"
+
+typedef struct {
+    int64_t timestamp_us;               // esp_timer time the event was logged
+    uint32_t args[3];
+    uint32_t id;                        // event_id_t
+} event_t;
+
+static TaskHandle_t event_task_handle;
+static spsc_queue_t event_queue;        // attempt loop -> formatting task
+static event_t event_buffer[EVENT_LOG_QUEUE_LEN];
+static atomic_uint_fast32_t events_dropped;
+
+// wall clock time of day an esp_timer timestamp corresponds to
+static void event_log_time(int64_t timestamp_us, char *text, size_t size)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t age_us = esp_timer_get_time() - timestamp_us;
+    time_t seconds = now.tv_sec - (time_t)((age_us - now.tv_usec + 999999) / 1000000);
+
+    struct tm timeinfo;
+    localtime_r(&seconds, &timeinfo);
+    strftime(text, size, "%X", &timeinfo);
+}
+
+static void event_log_format(const event_t *event)
+{
+    char timestr[16];
+    event_log_time(event->timestamp_us, timestr, sizeof(timestr));
+
+    switch (event->id)
+    {
+    case EVENT_ATTEMPT:
+        ESP_LOGI(LOG_TAG, "%s Trying pin %0*lu", timestr, (int)event->args[1], (unsigned long)event->args[0]);
+        break;
+    case EVENT_FIRST_ATTEMPT:
+        ESP_LOGI(LOG_TAG, "%s First attempt %lld ms after reset", timestr, (long long)(event->timestamp_us / 1000));
+        break;
+    default:
+        ESP_LOGW(LOG_TAG, "%s Unknown event %lu", timestr, (unsigned long)event->id);
+        break;
+    }
+}
+
+static void event_log_task(void *arg)
+{
+    for (;;)
+    {
+        // asleep until something is logged, then at most one drain per EVENT_LOG_DRAIN_MS
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t dropped = atomic_exchange(&events_dropped, 0);
+        if (dropped > 0)
+        {
+            ESP_LOGW(LOG_TAG, "%lu events dropped", (unsigned long)dropped);
+        }
+
+        event_t event;
+        while (spsc_queue_pop(&event_queue, &event))
+        {
+            event_log_format(&event);
+        }
+        vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_DRAIN_MS));
+    }
+}
+
+esp_err_t event_log_init(void)
+{
+    spsc_queue_init(&event_queue, event_buffer, sizeof(event_buffer[0]), EVENT_LOG_QUEUE_LEN);
+    atomic_init(&events_dropped, 0);
+
+    if (xTaskCreate(event_log_task, "event_log", EVENT_LOG_TASK_STACK_SIZE, NULL,
+                    EVENT_LOG_TASK_PRIORITY, &event_task_handle) != pdPASS)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to create event log task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+void event_log(event_id_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    const event_t event = {
+        .timestamp_us = esp_timer_get_time(),
+        .args = { arg0, arg1, arg2 },
+        .id = id,
+    };
+    if (!spsc_queue_push(&event_queue, &event))
+    {
+        atomic_fetch_add(&events_dropped, 1);
+    }
+    xTaskNotifyGive(event_task_handle);
+}
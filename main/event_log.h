@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Deferred formatting log for the attempt loop
+ *
+ * Logging an event only stores its id, an esp_timer timestamp and up to
+ * three arguments in a lock-free ring, so the keystroke path never formats a
+ * string, reads the wall clock or waits on the UART. A low priority task,
+ * woken by a notification when something is logged and otherwise blocked,
+ * drains the ring at most every EVENT_LOG_DRAIN_MS and does the formatting,
+ * turning the timestamps into wall clock times. Events that find the ring full are
+ * counted and the count is reported with the next ones that fit.
+ *
+ * The ring is single producer: only the task that runs the engine may log.
+ */
+
+#define EVENT_LOG_QUEUE_LEN          64      // events buffered, power of two
+#define EVENT_LOG_DRAIN_MS           100
+#define EVENT_LOG_TASK_PRIORITY      1
+#define EVENT_LOG_TASK_STACK_SIZE    3072
+
+typedef enum {
+    EVENT_ATTEMPT,                      // value, digits: about to type a passcode
+    EVENT_FIRST_ATTEMPT,                // the first passcode of this boot is about to be typed
+} event_id_t;
+
+// set up the ring and start the formatting task, before anything is logged
+esp_err_t event_log_init(void);
+
+// record an event, never blocks
+void event_log(event_id_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2);
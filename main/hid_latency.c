@@ -0,0 +1,140 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "hid_stream.h"
+#include "hid_timing.h"
+#include "hid_transmitter.h"
+#include "hid_latency.h"
+
+#define LOG_TAG                "hid_latency"
+#define HID_LATENCY_SETTLE_MS  50              // between toggles, so the host sees separate presses
+
+static SemaphoreHandle_t led_reported;
+
+// latest LED report, written by the TinyUSB task before giving led_reported
+static volatile uint8_t led_state;
+static volatile int64_t led_time_us;
+
+esp_err_t hid_latency_init(void)
+{
+    led_reported = xSemaphoreCreateBinary();
+    return led_reported != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void hid_latency_led_report(uint8_t leds)
+{
+    led_time_us = esp_timer_get_time();
+    led_state = leds;
+    if (led_reported != NULL)
+    {
+        xSemaphoreGive(led_reported);
+    }
+}
+
+static void hid_latency_add(hid_latency_histogram_t *histogram, uint32_t latency_us)
+{
+    uint32_t bucket = latency_us / HID_LATENCY_BUCKET_US;
+    histogram->buckets[bucket < HID_LATENCY_BUCKETS ? bucket : HID_LATENCY_BUCKETS - 1]++;
+    histogram->min_us = histogram->samples == 0 || latency_us < histogram->min_us ? latency_us : histogram->min_us;
+    histogram->max_us = latency_us > histogram->max_us ? latency_us : histogram->max_us;
+    histogram->total_us += latency_us;
+    histogram->samples++;
+}
+
+// press and release the lock key and time until the host reports the lock flipped
+static esp_err_t hid_latency_toggle(const hid_stream_t *stream, uint32_t *latency_us)
+{
+    uint8_t before = led_state & HID_LATENCY_LED_NUM_LOCK;
+    xSemaphoreTake(led_reported, 0);
+
+    // the press goes out at once, the host acts on it without waiting for the release
+    int64_t sent_us = esp_timer_get_time();
+    esp_err_t ret = hid_transmitter_send(stream, pdMS_TO_TICKS(HID_TRANSMITTER_TIMEOUT_MS));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(HID_LATENCY_TIMEOUT_MS);
+    while ((led_state & HID_LATENCY_LED_NUM_LOCK) == before)
+    {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0 || xSemaphoreTake(led_reported, deadline - now) != pdTRUE)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    *latency_us = (uint32_t)(led_time_us - sent_us);
+    return ESP_OK;
+}
+
+static void hid_latency_log(const hid_latency_histogram_t *histogram)
+{
+    ESP_LOGI(LOG_TAG, "%lu samples: min %lu us, mean %lu us, p50 < %lu us, p95 < %lu us, max %lu us",
+             (unsigned long)histogram->samples, (unsigned long)histogram->min_us,
+             (unsigned long)(histogram->total_us / histogram->samples),
+             (unsigned long)hid_latency_percentile_us(histogram, 50),
+             (unsigned long)hid_latency_percentile_us(histogram, 95), (unsigned long)histogram->max_us);
+    for (int i = 0; i < HID_LATENCY_BUCKETS; i++)
+    {
+        if (histogram->buckets[i] > 0)
+        {
+            ESP_LOGI(LOG_TAG, "  %3d-%3d%s ms  %lu", i * HID_LATENCY_BUCKET_US / 1000,
+                     (i + 1) * HID_LATENCY_BUCKET_US / 1000, i == HID_LATENCY_BUCKETS - 1 ? "+" : " ",
+                     (unsigned long)histogram->buckets[i]);
+        }
+    }
+}
+
+esp_err_t hid_latency_measure(uint32_t probes, hid_latency_histogram_t *histogram)
+{
+    memset(histogram, 0, sizeof(*histogram));
+
+    hid_stream_t stream;
+    // timed with the default profile, a calibrated one is what comes out of this
+    hid_stream_key(&stream, HID_STREAM_KEY_NUM_LOCK, &hid_timing_default, hid_timing_default.key_gap_us);
+
+    // twice per probe, leaving the lock as the host had it
+    for (uint32_t i = 0; i < 2 * probes; i++)
+    {
+        uint32_t latency_us;
+        esp_err_t ret = hid_latency_toggle(&stream, &latency_us);
+        if (ret == ESP_ERR_TIMEOUT && histogram->samples == 0)
+        {
+            ESP_LOGW(LOG_TAG, "Host does not report its keyboard LEDs, no latency measured");
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW(LOG_TAG, "Probe %lu got no answer", (unsigned long)i);
+            continue;
+        }
+        hid_latency_add(histogram, latency_us);
+        vTaskDelay(pdMS_TO_TICKS(HID_LATENCY_SETTLE_MS));
+    }
+
+    if (histogram->samples == 0)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    hid_latency_log(histogram);
+    return ESP_OK;
+}
+
+uint32_t hid_latency_percentile_us(const hid_latency_histogram_t *histogram, uint32_t percent)
+{
+    uint64_t wanted = ((uint64_t)histogram->samples * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < HID_LATENCY_BUCKETS && histogram->samples > 0; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= wanted)
+        {
+            // the overflow bucket has no upper edge, the slowest sample stands in for it
+            return i == HID_LATENCY_BUCKETS - 1 ? histogram->max_us : (i + 1) * HID_LATENCY_BUCKET_US;
+        }
+    }
+    return 0;
+}
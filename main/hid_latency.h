@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Host round trip latency, timed with a lock key and the keyboard LEDs
+ *
+ * Pressing Num Lock makes the host flip its lock state and send the new LED
+ * state back as an output report. The time from sending the press to that
+ * report arriving is how long the host takes to act on a keystroke, which
+ * is what the key timing has to allow for. Every probe toggles the lock
+ * twice, so the host is left as it was, and counts as two samples.
+ *
+ * Samples go into a histogram of HID_LATENCY_BUCKETS buckets
+ * HID_LATENCY_BUCKET_US wide, the last one collecting everything slower.
+ */
+
+#define HID_LATENCY_BUCKETS          20
+#define HID_LATENCY_BUCKET_US        5000
+#define HID_LATENCY_TIMEOUT_MS       500     // a host that has not answered by now does not echo the LEDs
+#define HID_LATENCY_LED_NUM_LOCK     0x01    // bit in the keyboard LED output report
+
+typedef struct {
+    uint32_t buckets[HID_LATENCY_BUCKETS];
+    uint32_t samples;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} hid_latency_histogram_t;
+
+// set up before the probe can run, after hid_transmitter_init()
+esp_err_t hid_latency_init(void);
+
+// hand over the LED output report from tud_hid_set_report_cb(), runs in the TinyUSB task
+void hid_latency_led_report(uint8_t leds);
+
+// run `probes` lock key round trips with the host attached, filling `histogram` and logging it.
+// Returns ESP_ERR_NOT_SUPPORTED if the host never reports its LEDs
+esp_err_t hid_latency_measure(uint32_t probes, hid_latency_histogram_t *histogram);
+
+// latency below which `percent` of the samples fall, to the bucket's upper edge; 0 if there are none
+uint32_t hid_latency_percentile_us(const hid_latency_histogram_t *histogram, uint32_t percent);
@@ -0,0 +1,68 @@
+#include <string.h>
+#include "hid_stream.h"
+
+static void hid_stream_append(hid_stream_t *stream, uint8_t keycode, uint32_t hold_us)
+{
+    hid_stream_report_t *report = &stream->reports[stream->count++];
+    memset(report, 0, sizeof(*report));
+    report->keycode[0] = keycode;
+    report->hold_us = hold_us;
+}
+
+void hid_stream_passcode(hid_stream_t *stream, const candidate_t *candidate, const hid_timing_t *timing)
+{
+    uint32_t passcode = candidate->value;
+    uint8_t digits = candidate->digits;
+    if (digits > DICT_MAX_DIGITS)
+    {
+        digits = DICT_MAX_DIGITS;
+    }
+
+    // fill the text from the right so leading zeros are kept
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        stream->text[i] = '0' + passcode % 10;
+        passcode /= 10;
+    }
+    stream->text[digits] = '\0';
+
+    stream->count = 0;
+    for (int i = 0; i < digits; i++)
+    {
+        uint8_t keycode = stream->text[i] == '0' ? HID_STREAM_KEY_0 : HID_STREAM_KEY_1 + (stream->text[i] - '1');
+        hid_stream_append(stream, keycode, timing->key_hold_us);
+        hid_stream_append(stream, HID_STREAM_KEY_NONE, timing->key_gap_us);
+    }
+}
+
+void hid_stream_clear(hid_stream_t *stream, const hid_timing_t *timing)
+{
+    stream->count = 0;
+    stream->text[0] = '\0';
+    for (int i = 0; i < DICT_MAX_DIGITS; i++)
+    {
+        hid_stream_append(stream, HID_STREAM_KEY_BACKSPACE, timing->key_hold_us);
+        hid_stream_append(stream, HID_STREAM_KEY_NONE, timing->key_gap_us);
+    }
+}
+
+void hid_stream_key(hid_stream_t *stream, uint8_t keycode, const hid_timing_t *timing, uint32_t release_us)
+{
+    stream->count = 0;
+    stream->text[0] = '\0';
+    hid_stream_append(stream, keycode, timing->key_hold_us);
+    hid_stream_append(stream, HID_STREAM_KEY_NONE, release_us);
+}
+
+char hid_stream_key_digit(uint8_t keycode)
+{
+    if (keycode == HID_STREAM_KEY_0)
+    {
+        return '0';
+    }
+    if (keycode >= HID_STREAM_KEY_1 && keycode < HID_STREAM_KEY_0)
+    {
+        return '1' + (keycode - HID_STREAM_KEY_1);
+    }
+    return '\0';
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include "dict_format.h"
+#include "candidate.h"
+#include "hid_timing.h"
+
+/**
+ * @brief Keystrokes for one passcode as ready-to-send keyboard reports
+ *
+ * A passcode is turned into its press and release reports once, when it is
+ * loaded, so sending it is just handing report after report to the endpoint.
+ * Every digit is typed, leading zeros included, for any length up to
+ * DICT_MAX_DIGITS. Each report carries how long it is held before the next
+ * one goes out, taken from a timing profile (see hid_timing.h).
+ */
+
+// keyboard usage IDs (HID Usage Tables, keyboard/keypad page)
+#define HID_STREAM_KEY_NONE    0x00
+#define HID_STREAM_KEY_1       0x1E    // 1 to 9 follow in order
+#define HID_STREAM_KEY_0       0x27
+#define HID_STREAM_KEY_ENTER   0x28
+#define HID_STREAM_KEY_BACKSPACE 0x2A
+#define HID_STREAM_KEY_NUM_LOCK 0x53
+
+#define HID_STREAM_MAX_REPORTS (2 * DICT_MAX_DIGITS)    // a press and a release per digit
+
+typedef struct {
+    uint8_t modifier;
+    uint8_t keycode[6];
+    uint32_t hold_us;                   // time to hold this report before sending the next
+} hid_stream_report_t;
+
+typedef struct {
+    hid_stream_report_t reports[HID_STREAM_MAX_REPORTS];
+    uint8_t count;
+    char text[DICT_MAX_DIGITS + 1];     // the passcode as typed, for logging
+} hid_stream_t;
+
+// build the reports typing every digit of `candidate`, leading zeros included
+void hid_stream_passcode(hid_stream_t *stream, const candidate_t *candidate, const hid_timing_t *timing);
+
+// build the reports pressing Backspace once for every digit a passcode may have, emptying a
+// field left partly typed
+void hid_stream_clear(hid_stream_t *stream, const hid_timing_t *timing);
+
+// build the reports pressing and releasing a single key, the release held for `release_us`
+void hid_stream_key(hid_stream_t *stream, uint8_t keycode, const hid_timing_t *timing, uint32_t release_us);
+
+// digit character typed by a keycode, '\0' if it is not a digit key
+char hid_stream_key_digit(uint8_t keycode);
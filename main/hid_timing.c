@@ -0,0 +1,45 @@
+#include <string.h>
+#include "hid_timing.h"
+
+#define HID_TIMING_MIN_SETTLE_US 50000  // Enter is never followed sooner than the default allows
+
+typedef struct {
+    const char *name;
+    hid_timing_t timing;
+} hid_timing_profile_t;
+
+const hid_timing_t hid_timing_default = {
+    .key_hold_us = 50000,
+    .key_gap_us = 50000,
+    .enter_settle_us = 50000,
+};
+
+static const hid_timing_profile_t hid_timing_profiles[] = {
+    { HID_TIMING_PROFILE_DEFAULT, { 50000, 50000, 50000 } },
+    { "fast", { 20000, 20000, 50000 } },         // desktops that keep up with a fast typist
+    { "slow", { 100000, 100000, 250000 } },      // sluggish lock screens and KVM switches
+};
+
+esp_err_t hid_timing_profile(const char *name, hid_timing_t *timing)
+{
+    for (size_t i = 0; i < sizeof(hid_timing_profiles) / sizeof(hid_timing_profiles[0]); i++)
+    {
+        if (strcmp(name, hid_timing_profiles[i].name) == 0)
+        {
+            *timing = hid_timing_profiles[i].timing;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+void hid_timing_calibrate(hid_timing_t *timing, uint32_t latency_us, uint32_t poll_us)
+{
+    // a report held for less than two polls may be replaced before the host has read it
+    uint32_t hold_us = latency_us > 2 * poll_us ? latency_us : 2 * poll_us;
+    uint32_t settle_us = 2 * hold_us > HID_TIMING_MIN_SETTLE_US ? 2 * hold_us : HID_TIMING_MIN_SETTLE_US;
+
+    timing->key_hold_us = hold_us;
+    timing->key_gap_us = hold_us;
+    timing->enter_settle_us = settle_us;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief How long keystrokes are held, per target
+ *
+ * A profile gives the time each key press is held, the gap after each
+ * release before the next key and how long to wait after Enter before
+ * anything else is typed, all in microseconds. The transmitter times them
+ * with one-shot esp_timer alarms, so they are not rounded to RTOS ticks.
+ *
+ * Named profiles cover the usual targets. A calibrated profile is derived
+ * from the host's measured round trip latency (see hid_latency.h): each key
+ * is held until the host has normally acted on it, and Enter gets twice as
+ * long since the target has to check the passcode.
+ */
+
+#define HID_TIMING_PROFILE_DEFAULT     "default"
+#define HID_TIMING_PROFILE_CALIBRATED  "calibrated"
+
+typedef struct {
+    uint32_t key_hold_us;               // each press, before the release goes out
+    uint32_t key_gap_us;                // each release, before the next press
+    uint32_t enter_settle_us;           // release of Enter, before the next passcode
+} hid_timing_t;
+
+// what the firmware always used: 50 ms for every press and release
+extern const hid_timing_t hid_timing_default;
+
+// look up a named profile, ESP_ERR_NOT_FOUND leaving `timing` untouched if there is none.
+// "calibrated" is not in the table, it needs hid_timing_calibrate()
+esp_err_t hid_timing_profile(const char *name, hid_timing_t *timing);
+
+// profile for a host that acts on 95% of keystrokes within `latency_us`,
+// never holding a report for less than two polls of `poll_us`
+void hid_timing_calibrate(hid_timing_t *timing, uint32_t latency_us, uint32_t poll_us);
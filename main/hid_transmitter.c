@@ -0,0 +1,111 @@
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "tinyusb.h"
+#include "class/hid/hid_device.h"
+#include "hid_transmitter.h"
+
+#define LOG_TAG                "hid_tx"
+
+static esp_timer_handle_t report_timer;
+static SemaphoreHandle_t stream_done;
+static SemaphoreHandle_t stream_lock;   // held by the timer callback while it runs
+static uint32_t busy_retry_us;
+
+// stream being sent, only touched with stream_lock held
+static const hid_stream_t *stream;
+static uint8_t next_report;
+static bool sending;                    // cleared when the sender gives up, so a late alarm does nothing
+
+// the report on the wire has been held long enough, send the next one and arm the timer for its hold
+static void hid_transmitter_next(void *arg)
+{
+    xSemaphoreTake(stream_lock, portMAX_DELAY);
+    if (!sending)
+    {
+        xSemaphoreGive(stream_lock);
+        return;
+    }
+
+    if (next_report == stream->count)
+    {
+        sending = false;
+        xSemaphoreGive(stream_done);
+    }
+    else if (!tud_hid_ready())
+    {
+        // endpoint still busy with the previous report, try again shortly
+        esp_timer_start_once(report_timer, busy_retry_us);
+    }
+    else
+    {
+        const hid_stream_report_t *report = &stream->reports[next_report++];
+        tud_hid_keyboard_report(HID_ITF_PROTOCOL_KEYBOARD, report->modifier, report->keycode);
+        esp_timer_start_once(report_timer, report->hold_us);
+    }
+    xSemaphoreGive(stream_lock);
+}
+
+esp_err_t hid_transmitter_init(uint32_t retry_us)
+{
+    stream_done = xSemaphoreCreateBinary();
+    stream_lock = xSemaphoreCreateMutex();
+    if (stream_done == NULL || stream_lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = hid_transmitter_next,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "hid_tx",
+    };
+    busy_retry_us = retry_us;
+    return esp_timer_create(&timer_args, &report_timer);
+}
+
+esp_err_t hid_transmitter_send(const hid_stream_t *reports, TickType_t timeout)
+{
+    xSemaphoreTake(stream_lock, portMAX_DELAY);
+    stream = reports;
+    next_report = 0;
+    sending = true;
+    xSemaphoreTake(stream_done, 0);
+
+    // first report goes out from the timer task like the rest, so the callback never runs twice at once
+    esp_err_t ret = esp_timer_start_once(report_timer, 0);
+    xSemaphoreGive(stream_lock);
+    if (ret != ESP_OK)
+    {
+        sending = false;
+        return ret;
+    }
+
+    if (xSemaphoreTake(stream_done, timeout) == pdTRUE)
+    {
+        return ESP_OK;
+    }
+
+    // wait out a callback that is running, then make sure no key is left held down
+    xSemaphoreTake(stream_lock, portMAX_DELAY);
+    esp_timer_stop(report_timer);
+    bool finished = !sending;
+    sending = false;
+    uint8_t sent = next_report;
+    if (!finished && sent > 0 && reports->reports[sent - 1].keycode[0] != HID_STREAM_KEY_NONE
+        && !(tud_hid_ready() && tud_hid_keyboard_report(HID_ITF_PROTOCOL_KEYBOARD, 0, NULL)))
+    {
+        ESP_LOGW(LOG_TAG, "Could not release the key, the host clears it when the link comes back");
+    }
+    xSemaphoreGive(stream_lock);
+
+    // the last report was held out just as the wait ran out
+    if (finished)
+    {
+        return ESP_OK;
+    }
+
+    ESP_LOGW(LOG_TAG, "Gave up sending after %u of %u reports", sent, reports->count);
+    return ESP_ERR_TIMEOUT;
+}
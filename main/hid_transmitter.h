@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "hid_stream.h"
+
+/**
+ * @brief Timer driven keyboard report transmitter
+ *
+ * A one-shot esp_timer pushes the reports of a hid_stream_t one after the
+ * other, re-armed after each for that report's hold_us, so holds keep the
+ * timer's microsecond resolution instead of being rounded to RTOS ticks.
+ * While the endpoint is still busy with the previous report it retries
+ * every `retry_us`. The sending task blocks once for the whole stream
+ * instead of waking for every key.
+ *
+ * The alarm runs in the esp_timer task rather than in an interrupt, as
+ * TinyUSB must not be called from an ISR.
+ */
+
+#define HID_TRANSMITTER_TIMEOUT_MS   5000    // longest a stream may take, e.g. while the host has us suspended
+
+// create the timer, `retry_us` is normally a fraction of the endpoint's poll interval
+esp_err_t hid_transmitter_init(uint32_t retry_us);
+
+// send every report in `stream` and block until the last one has been held. On ESP_ERR_TIMEOUT
+// the rest of the stream is dropped and a key left pressed is released, if the endpoint allows
+esp_err_t hid_transmitter_send(const hid_stream_t *stream, TickType_t timeout);
@@ -0,0 +1,225 @@
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "journal.h"
+#include "crc32.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_random.h"
+#include "esp_vfs_fat.h"
+#else
+#include <stdlib.h>
+#include <time.h>
+#endif
+
+#define LOG_TAG                "journal"
+
+static uint32_t journal_new_epoch(void)
+{
+#ifdef ESP_PLATFORM
+    return esp_random();
+#else
+    return (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16) ^ (uint32_t)rand();
+#endif
+}
+
+static uint32_t journal_record_crc(const journal_t *journal, const journal_record_t *record)
+{
+    return crc32_update(journal->epoch, record, offsetof(journal_record_t, crc32));
+}
+
+static long journal_record_offset(uint32_t sequence)
+{
+    // the file header occupies the first record slot, record n lives in slot n
+    return (long)sequence * JOURNAL_RECORD_SIZE;
+}
+
+// check whether record slot `sequence` holds the record with that sequence number
+static bool journal_record_valid(journal_t *journal, uint32_t sequence)
+{
+    journal_record_t record;
+    if (fseek(journal->file, journal_record_offset(sequence), SEEK_SET) != 0
+        || fread(&record, sizeof(record), 1, journal->file) != 1)
+    {
+        return false;
+    }
+    return record.magic == JOURNAL_RECORD_MAGIC
+        && record.sequence == sequence
+        && record.crc32 == journal_record_crc(journal, &record);
+}
+
+static esp_err_t journal_sync(journal_t *journal)
+{
+    if (fflush(journal->file) != 0 || fsync(fileno(journal->file)) != 0)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to sync journal");
+        return ESP_FAIL;
+    }
+    journal->unsynced = 0;
+    return ESP_OK;
+}
+
+static esp_err_t journal_create(journal_t *journal, const journal_config_t *config)
+{
+#ifdef ESP_PLATFORM
+    // reserve one contiguous cluster run up front so appends never walk or extend the FAT
+    if (config->prealloc_size > 0
+        && esp_vfs_fat_create_contiguous_file(config->base_path, config->path, config->prealloc_size, true) != ESP_OK)
+    {
+        ESP_LOGW(LOG_TAG, "Could not preallocate %u bytes, journal will grow on demand", (unsigned)config->prealloc_size);
+    }
+#endif
+
+    journal->file = fopen(config->path, "r+b");
+    if (journal->file == NULL)
+    {
+        journal->file = fopen(config->path, "w+b");
+    }
+    if (journal->file == NULL)
+    {
+        return ESP_FAIL;
+    }
+
+    journal_file_header_t header = {
+        .magic = JOURNAL_FILE_MAGIC,
+        .version = JOURNAL_VERSION,
+        .record_size = JOURNAL_RECORD_SIZE,
+        .epoch = journal_new_epoch(),
+    };
+    header.crc32 = crc32_update(0, &header, offsetof(journal_file_header_t, crc32));
+    journal->epoch = header.epoch;
+
+    if (fwrite(&header, sizeof(header), 1, journal->file) != 1)
+    {
+        return ESP_FAIL;
+    }
+    return journal_sync(journal);
+}
+
+static esp_err_t journal_load(journal_t *journal, const journal_config_t *config)
+{
+    journal->file = fopen(config->path, "r+b");
+    if (journal->file == NULL)
+    {
+        return ESP_FAIL;
+    }
+
+    journal_file_header_t header;
+    if (fread(&header, sizeof(header), 1, journal->file) != 1
+        || memcmp(header.magic, JOURNAL_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != JOURNAL_VERSION
+        || header.record_size != JOURNAL_RECORD_SIZE
+        || header.crc32 != crc32_update(0, &header, offsetof(journal_file_header_t, crc32)))
+    {
+        ESP_LOGE(LOG_TAG, "%s is not a journal", config->path);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    journal->epoch = header.epoch;
+
+    // valid records form a prefix of the file (a torn final record just fails its CRC),
+    // so bisect for the first slot that does not hold its record
+    fseek(journal->file, 0, SEEK_END);
+    uint32_t slots = ftell(journal->file) / JOURNAL_RECORD_SIZE;
+    uint32_t lo = 1;
+    uint32_t hi = slots;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (journal_record_valid(journal, mid))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    journal->sequence = lo - 1;
+
+    // past the end the slots are blank (preallocated) or stale, anything else was torn or damaged
+    journal_record_t record;
+    if (lo < slots
+        && fseek(journal->file, journal_record_offset(lo), SEEK_SET) == 0
+        && fread(&record, sizeof(record), 1, journal->file) == 1
+        && record.magic == JOURNAL_RECORD_MAGIC
+        && record.sequence == lo)
+    {
+        ESP_LOGW(LOG_TAG, "Record %lu fails its CRC, appending over it", (unsigned long)lo);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t journal_open(journal_t *journal, const journal_config_t *config)
+{
+    memset(journal, 0, sizeof(*journal));
+    journal->sync_policy = config->sync_policy;
+
+    struct stat st;
+    esp_err_t ret = stat(config->path, &st) == 0 ? journal_load(journal, config) : journal_create(journal, config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open %s", config->path);
+        journal_close(journal);
+        return ret;
+    }
+
+    if (fseek(journal->file, journal_record_offset(journal->sequence + 1), SEEK_SET) != 0)
+    {
+        journal_close(journal);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(LOG_TAG, "Journal open, %lu records", (unsigned long)journal->sequence);
+
+    return ESP_OK;
+}
+
+esp_err_t journal_append(journal_t *journal, journal_record_t *record)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    record->magic = JOURNAL_RECORD_MAGIC;
+    record->sequence = journal->sequence + 1;
+    record->timestamp_us = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+    record->crc32 = journal_record_crc(journal, record);
+
+    if (fwrite(record, sizeof(*record), 1, journal->file) != 1)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to append record %lu", (unsigned long)record->sequence);
+        return ESP_FAIL;
+    }
+    journal->sequence = record->sequence;
+    journal->unsynced++;
+
+    if (journal->sync_policy == JOURNAL_SYNC_APPEND)
+    {
+        return journal_sync(journal);
+    }
+    return ESP_OK;
+}
+
+esp_err_t journal_commit(journal_t *journal)
+{
+    if (journal->sync_policy == JOURNAL_SYNC_COMMIT && journal->unsynced > 0)
+    {
+        return journal_sync(journal);
+    }
+    return ESP_OK;
+}
+
+void journal_close(journal_t *journal)
+{
+    if (journal->file != NULL)
+    {
+        if (journal->unsynced > 0)
+        {
+            journal_sync(journal);
+        }
+        fclose(journal->file);
+        journal->file = NULL;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "journal_format.h"
+
+/**
+ * @brief Append-only attempt journal
+ *
+ * The journal file is kept open for the whole run and holds fixed size
+ * records after a one record file header. Every record carries a sequence
+ * number and a CRC32 seeded with a per-file epoch, so stale data left in
+ * preallocated clusters is never mistaken for a record and the end of the
+ * journal can be found by bisection when it is reopened.
+ */
+
+typedef enum {
+    JOURNAL_SYNC_APPEND,                // fsync after every appended record
+    JOURNAL_SYNC_COMMIT,                // fsync at journal_commit(), e.g. just before pressing Enter
+    JOURNAL_SYNC_CLOSE,                 // only fsync when the journal is closed
+} journal_sync_policy_t;
+
+typedef struct {
+    const char *base_path;              // VFS mount point the journal lives under
+    const char *path;                   // full path of the journal file
+    size_t prealloc_size;               // contiguous space reserved when the file is created
+    journal_sync_policy_t sync_policy;
+} journal_config_t;
+
+typedef struct {
+    FILE *file;
+    uint32_t epoch;                     // random per-file value seeding the record CRCs
+    uint32_t sequence;                  // sequence number of the last record written
+    uint32_t unsynced;                  // records appended since the last fsync
+    journal_sync_policy_t sync_policy;
+} journal_t;
+
+// open the journal (creating and preallocating it if needed) positioned after the last valid record
+esp_err_t journal_open(journal_t *journal, const journal_config_t *config);
+
+// append a record; type and payload fields are taken from `record`, the rest is filled in
+esp_err_t journal_append(journal_t *journal, journal_record_t *record);
+
+// durability point, syncs the journal to the card under JOURNAL_SYNC_COMMIT
+esp_err_t journal_commit(journal_t *journal);
+
+void journal_close(journal_t *journal);
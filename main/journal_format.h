@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Attempt journal on-disk format
+ *
+ * A journal file is a journal_file_header_t followed by journal_record_t
+ * records, both JOURNAL_RECORD_SIZE bytes, so record n (counting from 1)
+ * lives at byte offset n * JOURNAL_RECORD_SIZE. Record CRCs are seeded with
+ * the epoch from the file header.
+ */
+
+#define JOURNAL_RECORD_SIZE    32
+#define JOURNAL_FILE_MAGIC     "RRJL"
+#define JOURNAL_VERSION        1
+#define JOURNAL_RECORD_MAGIC   0x4345524A      // "JREC"
+#define JOURNAL_BOOT_MS_MAX    0xFFFFF         // boot times saturate here, about 17 minutes
+
+// times in a JOURNAL_RECORD_BOOT, in milliseconds since reset
+typedef enum {
+    JOURNAL_BOOT_USB,                   // USB stack installed
+    JOURNAL_BOOT_CARD,                  // card mounted and probed
+    JOURNAL_BOOT_FILES,                 // dictionaries, visited bitmap, checkpoint and journal open
+    JOURNAL_BOOT_RESUMED,               // resume point found and the dictionaries positioned on it
+    JOURNAL_BOOT_TIMES,
+} journal_boot_time_t;
+
+typedef enum {
+    JOURNAL_RECORD_ATTEMPT = 1,         // a passcode about to be submitted
+    JOURNAL_RECORD_SESSION = 2,         // start of a boot's attempts: how the card was brought up
+    JOURNAL_RECORD_BOOT = 3,            // follows the session record: when each boot phase finished
+    JOURNAL_RECORD_LATENCY = 4,         // host round trip latency measured this boot, if enabled
+} journal_record_type_t;
+
+typedef struct {
+    uint32_t magic;                     // filled in by journal_append()
+    uint32_t sequence;                  // filled in by journal_append(), first record is 1
+    int64_t timestamp_us;               // wall clock time the record was appended
+    union {
+        struct {                        // JOURNAL_RECORD_ATTEMPT
+            uint32_t dict_index;
+            uint32_t passcode;
+        };
+        struct {                        // JOURNAL_RECORD_SESSION
+            uint16_t sd_freq_khz;       // bus clock the card runs at
+            uint8_t sd_bus_width;       // data lines in use
+            uint8_t reset_reason;       // esp_reset_reason_t that started this boot
+            uint16_t sd_write_kbps;     // KB/s measured by the probe at mount, 0 if not run
+            uint16_t sd_read_kbps;
+        };
+        struct {                        // JOURNAL_RECORD_BOOT, see journal_boot_ms()
+            uint16_t boot_ms[JOURNAL_BOOT_TIMES];   // low 16 bits of each journal_boot_time_t
+        };
+        struct {                        // JOURNAL_RECORD_LATENCY, see hid_latency.h
+            uint16_t latency_samples;
+            uint16_t latency_p50_ms;    // upper edge of the histogram bucket holding the median
+            uint16_t latency_p95_ms;
+            uint16_t latency_max_ms;
+        };
+    };
+    uint8_t type;                       // journal_record_type_t
+    uint8_t digits;                     // attempts only
+    uint16_t extra;                     // JOURNAL_RECORD_BOOT: bits 16-19 of each boot time, four bits
+                                        // each starting from the lowest; otherwise zero
+    uint32_t crc32;                     // filled in by journal_append()
+} journal_record_t;
+
+_Static_assert(sizeof(journal_record_t) == JOURNAL_RECORD_SIZE, "journal records must be 32 bytes");
+
+// store boot time `time` of a JOURNAL_RECORD_BOOT, saturating at JOURNAL_BOOT_MS_MAX
+static inline void journal_boot_set_ms(journal_record_t *record, journal_boot_time_t time, int64_t ms)
+{
+    uint32_t stored = ms > JOURNAL_BOOT_MS_MAX ? JOURNAL_BOOT_MS_MAX : (uint32_t)ms;
+    record->boot_ms[time] = stored & 0xFFFF;
+    record->extra = (record->extra & ~(0xF << (4 * time))) | (stored >> 16) << (4 * time);
+}
+
+// boot time `time` of a JOURNAL_RECORD_BOOT, JOURNAL_BOOT_MS_MAX if it was longer
+static inline uint32_t journal_boot_ms(const journal_record_t *record, journal_boot_time_t time)
+{
+    return record->boot_ms[time] | (uint32_t)(record->extra >> (4 * time) & 0xF) << 16;
+}
+
+typedef struct {
+    char magic[4];                      // JOURNAL_FILE_MAGIC
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t epoch;
+    uint8_t reserved[16];
+    uint32_t crc32;                     // CRC32 of everything above
+} journal_file_header_t;
+
+_Static_assert(sizeof(journal_file_header_t) == JOURNAL_RECORD_SIZE, "journal header must be one record long");
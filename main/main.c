@@ -1,10 +1,15 @@
 // standard
 #include <stdlib.h>
+#include <string.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_pm.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 
 // USB HID
 #include "tinyusb.h"
@@ -16,21 +21,138 @@
 #include "sdmmc_cmd.h"
 #include "driver/sdmmc_host.h"
 
+// application
+#include "dict.h"
+#include "dict_chain.h"
+#include "dict_build.h"
+#include "dict_partition.h"
+#include "settings.h"
+#include "checkpoint.h"
+#include "journal.h"
+#include "visited.h"
+#include "storage_task.h"
+#include "hid_stream.h"
+#include "hid_transmitter.h"
+#include "status_link.h"
+#include "usb_link.h"
+#include "status_led.h"
+#include "hid_latency.h"
+#include "hid_timing.h"
+#include "event_log.h"
+#include "engine.h"
+#include "bench.h"
+
 // application constants
 #define LED_GPIO               2
+#define LED_LOCKOUT_MIN_US     (5 * 1000000LL)  // waits at least this long show as a lockout on the LED
 #define MOUNT_POINT            "/sdcard"
 #define PIN_SD_MMC_CMD         38
 #define PIN_SD_MMC_CLK         39
 #define PIN_SD_MMC_D0          40
+#define PIN_SD_MMC_D1          -1      // D1 to D3 are needed for 4-bit mode, -1 if the board does not wire them
+#define PIN_SD_MMC_D2          -1
+#define PIN_SD_MMC_D3          -1
+#define SD_PROBE_SIZE          (256 * 1024)    // written and read back at mount to check the bus mode
+#define PIN_SD_POWER           -1      // GPIO switching the card's supply, -1 if the board has none
+#define SD_POWER_ON_LEVEL      1
+#define SD_POWER_UP_MS         10      // supply ramp before talking to the card again
+#define SD_POWER_UP_TRIES      3       // bring-ups after a lockout before the card is given up on
+#define IDLE_CPU_FREQ_MHZ      80      // lowest CPU clock that keeps APB, and so USB and SDMMC, at 80 MHz
 #define LOG_TAG                "restless-rabbit"
-#define TUSB_DESC_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN)
+#define TUSB_DESC_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + CFG_TUD_CDC * TUD_CDC_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN)
+#define HID_POLL_INTERVAL_MS   10      // interrupt IN endpoint polling interval
+#define HID_BUSY_RETRY_US      1000    // while the endpoint has not sent the last report yet
 
-// name of the passcode attempts log file
+// name of the passcode log file written by older firmware, only read to resume their runs
 const char *passcode_log_filename = MOUNT_POINT"/pin.log";
 
+// attempt journal, preallocated with room for 32768 attempts
+const journal_config_t journal_config = {
+    .base_path = MOUNT_POINT,
+    .path = MOUNT_POINT"/ATTEMPTS.JNL",
+    .prealloc_size = 32768 * JOURNAL_RECORD_SIZE,
+    .sync_policy = JOURNAL_SYNC_COMMIT,
+};
+
+// name of the resume checkpoint file
+const char *checkpoint_filename = MOUNT_POINT"/RESUME.CKP";
+
+// name of the file recording every passcode tried on the target, across dictionaries
+const char *visited_filename = MOUNT_POINT"/VISITED.BIT";
+
+// run settings, e.g. which dictionary to use (see settings.h)
+#define SETTINGS_FILENAME      MOUNT_POINT"/RABBIT.CFG"
+
+// scratch directory and number of logged attempts for the on-device benchmarks
+#define BENCH_DIRECTORY        MOUNT_POINT"/BENCH"
+#define BENCH_APPENDS          100
+
 // SD card object
 sdmmc_card_t *card;
 
+// host and slot the card was mounted with, to bring it back up after powering it down
+static sdmmc_host_t sd_host;
+static sdmmc_slot_config_t sd_slot_config;
+
+// SD bus modes to try, fastest first; the first one the card mounts in and passes the probe with is kept
+typedef struct {
+    uint8_t width;
+    int freq_khz;
+} sd_bus_mode_t;
+
+static const sd_bus_mode_t sd_bus_modes[] = {
+    { 4, SDMMC_FREQ_HIGHSPEED },
+    { 4, SDMMC_FREQ_DEFAULT },
+    { 1, SDMMC_FREQ_HIGHSPEED },
+    { 1, SDMMC_FREQ_DEFAULT },
+};
+
+// throughput the probe measured in the mode that was kept, for the journal's session record
+static uint32_t sd_write_kbps;
+static uint32_t sd_read_kbps;
+
+// startup phases, timed to see where time-to-first-attempt goes after a reset
+typedef enum {
+    BOOT_PHASE_APP,                     // up to app_main(): bootloader and system startup
+    BOOT_PHASE_USB,
+    BOOT_PHASE_CARD,
+    BOOT_PHASE_FILES,
+    BOOT_PHASE_RESUME,
+    BOOT_PHASE_COUNT,
+} boot_phase_t;
+
+static const char *const boot_phase_names[BOOT_PHASE_COUNT] = {
+    "startup", "USB", "card", "files", "resume",
+};
+
+// esp_timer time each phase finished at
+static int64_t boot_phase_end_us[BOOT_PHASE_COUNT];
+
+// app_main brings USB up on its core while card_init_task mounts the card and opens the run's files
+// on the other, then waits here for the card task to finish
+#define BOOT_FILES_READY       BIT0
+#define BOOT_FILES_FAILED      BIT1
+#define CARD_INIT_TASK_CORE    1               // app_main and its USB setup run on core 0
+#define CARD_INIT_TASK_PRIORITY 1
+#define CARD_INIT_TASK_STACK_SIZE 8192         // FATFS mount and the benchmarks, freed once it is done
+
+static EventGroupHandle_t boot_events;
+
+// opened by card_init_task, then handed to the engine and the storage task
+static settings_t settings;
+static dict_chain_t chain;
+static visited_t visited;
+static checkpoint_t checkpoint;
+static journal_t journal;
+
+// scratch file for the mount time probe
+#define SD_PROBE_FILENAME      MOUNT_POINT"/PROBE.TMP"
+
+#if CONFIG_PM_ENABLE
+// held whenever the attempt loop is not sleeping, so typing and card I/O run at full speed
+static esp_pm_lock_handle_t attempt_pm_lock;
+#endif
+
 /**
  * @brief USB HID report descriptor
  *
@@ -43,28 +165,41 @@ const uint8_t hid_report_descriptor[] = {
 };
 
 /**
- * @brief USB HID string descriptor
+ * @brief USB string descriptor
  */
-const char* hid_string_descriptor[5] = {
+const char* hid_string_descriptor[6] = {
     // array of pointer to string descriptors
     (char[]){0x09, 0x04},     // 0: is supported language is English (0x0409)
     "TinyUSB",                // 1: Manufacturer
     "TinyUSB Device",         // 2: Product
     "123456",                 // 3: Serials, should use chip ID
     "Keyboard emulator",      // 4: HID
+    "Rabbit status",          // 5: CDC
+};
+
+// interface numbers, the CDC function takes two
+enum {
+    ITF_NUM_CDC = 0,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_HID,
+    ITF_NUM_TOTAL
 };
 
 /**
- * @brief USB HID configuration descriptor
+ * @brief USB configuration descriptor
  *
- * This is a simple configuration descriptor that defines 1 configuration and 1 HID interface
+ * One configuration with a CDC-ACM function for the status link (see status_link.h) and the
+ * HID keyboard interface
  */
 static const uint8_t hid_configuration_descriptor[] = {
     // Configuration number, interface count, string index, total length, attribute, power in mA
-    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+
+    // Interface number, string index, notification EP & size, data EP Out & In addresses, size
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 5, 0x81, 8, 0x02, 0x82, 64),
 
     // Interface number, string index, boot protocol, report descriptor len, EP In address, size & polling interval
-    TUD_HID_DESCRIPTOR(0, 4, false, sizeof(hid_report_descriptor), 0x81, 16, 10),
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 4, false, sizeof(hid_report_descriptor), 0x83, 16, HID_POLL_INTERVAL_MS),
 };
 
 // Invoked when received GET HID REPORT DESCRIPTOR request
@@ -93,151 +228,217 @@ uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_t
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize)
 {
+    // the host's keyboard LED state, TinyUSB has already stripped the report ID
+    if (report_type == HID_REPORT_TYPE_OUTPUT && report_id == HID_ITF_PROTOCOL_KEYBOARD && bufsize >= 1)
+    {
+        hid_latency_led_report(buffer[0]);
+    }
 }
 
-// Write line to file
-static esp_err_t write_line(const char *path, char *data)
+// block until the USB host has the keyboard configured and awake, blinking the status LED meanwhile.
+// The wait ends the moment the TinyUSB task reports the change
+static bool usb_wait_ready(void *ctx)
 {
-    FILE *f = fopen(path, "a");
-    if (f == NULL)
+    if (usb_link_wait_active(0))
     {
-        ESP_LOGE(LOG_TAG, "Failed to open file for appending");
-        return ESP_FAIL;
+        return false;
     }
-    fprintf(f, data);
-    fclose(f);
 
-    return ESP_OK;
+    status_led_set(STATUS_LED_WAITING);
+    usb_link_wait_active(portMAX_DELAY);
+    status_led_set(STATUS_LED_RUNNING);
+    return true;
+}
+
+// keystrokes for the next passcode, built when it is loaded, for Enter and for emptying the field
+static hid_stream_t passcode_stream;
+static hid_stream_t enter_stream;
+static hid_stream_t clear_stream;
+static bool field_dirty;                // a send failed, the field may hold part of a passcode
+static hid_timing_t key_timing;         // profile chosen in settings, set before the run starts
+
+static candidate_t prepared;            // passcode in passcode_stream, for the event log
+
+static void usb_prepare(void *ctx, const candidate_t *candidate)
+{
+    hid_stream_passcode(&passcode_stream, candidate, &key_timing);
+    prepared = *candidate;
 }
 
-// Read last line of file
-static esp_err_t read_last_passcode(int *passcode)
+// enter passcode digits by using USB HID interface to emulate keyboard presses
+static esp_err_t usb_type_passcode(void *ctx)
 {
-    FILE *f = fopen(passcode_log_filename, "r");
-    if (f == NULL)
+    static bool typed_any;
+    if (!typed_any)
     {
-        ESP_LOGE(LOG_TAG, "Failed to open file for reading");
-        return ESP_FAIL;
+        typed_any = true;
+        event_log(EVENT_FIRST_ATTEMPT, 0, 0, 0);
     }
-    
-    while (!feof(f))
+
+    // formatted later by the event log task, nothing here waits on the clock or the console
+    event_log(EVENT_ATTEMPT, prepared.value, prepared.digits, 0);
+
+    // digits left over from a send that failed would run into this passcode
+    if (field_dirty && hid_transmitter_send(&clear_stream, pdMS_TO_TICKS(HID_TRANSMITTER_TIMEOUT_MS)) != ESP_OK)
     {
-        fscanf(f, "%d", passcode);
+        return ESP_ERR_TIMEOUT;
     }
+    field_dirty = hid_transmitter_send(&passcode_stream, pdMS_TO_TICKS(HID_TRANSMITTER_TIMEOUT_MS)) != ESP_OK;
+    return field_dirty ? ESP_ERR_TIMEOUT : ESP_OK;
+}
 
-    fclose(f);
+// press/release enter key to submit passcode
+static esp_err_t usb_submit(void *ctx)
+{
+    field_dirty = hid_transmitter_send(&enter_stream, pdMS_TO_TICKS(HID_TRANSMITTER_TIMEOUT_MS)) != ESP_OK;
+    return field_dirty ? ESP_ERR_TIMEOUT : ESP_OK;
+}
 
-    return ESP_OK;
+static const hid_sink_t usb_hid_sink = {
+    .wait_ready = usb_wait_ready,
+    .prepare = usb_prepare,
+    .type_passcode = usb_type_passcode,
+    .submit = usb_submit,
+};
+
+static int64_t esp_clock_now_us(void *ctx)
+{
+    return esp_timer_get_time();
 }
 
-// enter passcode digits by using USB HID interface to emulate keyboard presses
-static void send_passcode(int passcode)
+// while every task is blocked here the power management drops the CPU to IDLE_CPU_FREQ_MHZ
+static void esp_clock_sleep_until(void *ctx, int64_t deadline_us)
 {
-    // get the 4 digits of the numeric passcode
-    const int passcode_len = 4;
-    uint8_t digits[passcode_len] = {};
-    char pincode_str[20];
-    int i = 0;
-    while (passcode > 0) {
-        digits[i] = passcode % 10;
-        passcode /= 10;
-        i++;
+    bool lockout = deadline_us - esp_timer_get_time() >= LED_LOCKOUT_MIN_US;
+    if (lockout)
+    {
+        status_led_set(STATUS_LED_LOCKOUT);
+    }
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_release(attempt_pm_lock);
+#endif
+    int64_t remaining_us;
+    while ((remaining_us = deadline_us - esp_timer_get_time()) > 0)
+    {
+        // convert in 64 bits and round up, pdMS_TO_TICKS() overflows its 32 bit intermediate for long lockouts
+        int64_t ticks = (remaining_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+        vTaskDelay(ticks > INT32_MAX ? INT32_MAX : (TickType_t)ticks);
+    }
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(attempt_pm_lock);
+#endif
+    if (lockout)
+    {
+        status_led_set(STATUS_LED_RUNNING);
     }
+}
+
+static const engine_clock_t esp_clock = {
+    .now_us = esp_clock_now_us,
+    .sleep_until = esp_clock_sleep_until,
+};
+
+// stops the card clock, which is all the power saving there is without a supply switch
+static void sd_card_power_down(void)
+{
+    sdmmc_host_deinit();
+#if PIN_SD_POWER >= 0
+    gpio_set_level(PIN_SD_POWER, !SD_POWER_ON_LEVEL);
+#endif
+}
 
-    // get current time
-    time_t now;
-    char timestr[64];
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    strftime(timestr, sizeof(timestr), "%X", &timeinfo);
-    
-    // write current pin to log file
-    sprintf(pincode_str, "%d%d%d%d\n", digits[3], digits[2], digits[1], digits[0]);
-    write_line(passcode_log_filename, pincode_str);
-
-    ESP_LOGI(LOG_TAG, "%s Trying pin %d%d%d%d", timestr, digits[3], digits[2], digits[1], digits[0]);
-
-    // enter the passcode
-    uint8_t keycode[6] = {};
-    for (int i = passcode_len - 1; i >= 0; i--)
+// called by the storage task around lockouts. The filesystem stays mounted: the journal and
+// checkpoint are synced before the card goes down and nothing reads it until it is back.
+// A card that does not come back is power cycled and tried again; if it still fails the storage
+// task fails every write after it, which stops the run before the next Enter
+static esp_err_t sd_card_power(bool on)
+{
+    if (!on)
     {
-        // HID_KEY_1 = 30
-        // HID_KEY_2 = 31
-        // HID_KEY_0 = 39
+        sd_card_power_down();
+        return ESP_OK;
+    }
 
-        if (digits[i] == 0)
+    esp_err_t ret = ESP_FAIL;
+    for (int tries = 1; tries <= SD_POWER_UP_TRIES; tries++)
+    {
+#if PIN_SD_POWER >= 0
+        gpio_set_level(PIN_SD_POWER, SD_POWER_ON_LEVEL);
+        vTaskDelay(pdMS_TO_TICKS(SD_POWER_UP_MS));
+#endif
+        ret = sdmmc_host_init();
+        if (ret == ESP_OK)
         {
-            keycode[0] = HID_KEY_0;
+            ret = sdmmc_host_init_slot(sd_host.slot, &sd_slot_config);
         }
-        else
+        if (ret == ESP_OK)
+        {
+            ret = sdmmc_card_init(&sd_host, card);
+        }
+        if (ret == ESP_OK)
         {
-            keycode[0] = HID_KEY_Z + digits[i];
+            return ESP_OK;
         }
 
-        // press key
-        tud_hid_keyboard_report(HID_ITF_PROTOCOL_KEYBOARD, 0, keycode);
-        vTaskDelay(pdMS_TO_TICKS(50));
+        ESP_LOGW(LOG_TAG, "SD card bring-up %d of %d failed (%s)", tries, SD_POWER_UP_TRIES, esp_err_to_name(ret));
+        sd_card_power_down();
+        vTaskDelay(pdMS_TO_TICKS(SD_POWER_UP_MS));
+    }
+
+    ESP_LOGE(LOG_TAG, "SD card did not come back up");
+    return ret;
+}
 
-        // release key
-        tud_hid_keyboard_report(HID_ITF_PROTOCOL_KEYBOARD, 0, NULL);
-        vTaskDelay(pdMS_TO_TICKS(50));
+// open one dictionary of the chain: flashed, packed on the card, or packed first if only on the card as text
+static esp_err_t open_dictionary(dict_t *dict, const char *name)
+{
+    if (strncmp(name, DICT_PARTITION_PREFIX, strlen(DICT_PARTITION_PREFIX)) == 0)
+    {
+        // flashed dictionary, read through the cache instead of from the card
+        return dict_open_partition(dict, name + strlen(DICT_PARTITION_PREFIX));
     }
 
-    // press/release enter key to submit passcode
-    keycode[0] = HID_KEY_ENTER;
-    tud_hid_keyboard_report(HID_ITF_PROTOCOL_KEYBOARD, 0, keycode);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    tud_hid_keyboard_report(HID_ITF_PROTOCOL_KEYBOARD, 0, NULL);
-    vTaskDelay(pdMS_TO_TICKS(50));
+    char path[sizeof(MOUNT_POINT) + SETTINGS_VALUE_MAX];
+    snprintf(path, sizeof(path), MOUNT_POINT"/%s", name);
+    return dict_open_or_build(dict, path);
 }
 
-// main application entry point
-void app_main(void)
+static int64_t bench_now_us(void)
 {
-    // initialize GPIO that will trigger HID reports
-    const gpio_config_t boot_button_config = {
-        .pin_bit_mask = BIT64(GPIO_NUM_0),
-        .mode = GPIO_MODE_INPUT,
-        .intr_type = GPIO_INTR_DISABLE,
-        .pull_up_en = true,
-        .pull_down_en = false,
-    };
-    ESP_ERROR_CHECK(gpio_config(&boot_button_config));
+    return esp_timer_get_time();
+}
 
-    ESP_LOGI(LOG_TAG, "USB initialization");
-    const tinyusb_config_t tusb_cfg = {
-        .device_descriptor = NULL,
-        .string_descriptor = hid_string_descriptor,
-        .string_descriptor_count = sizeof(hid_string_descriptor) / sizeof(hid_string_descriptor[0]),
-        .external_phy = false,
-#if (TUD_OPT_HIGH_SPEED)
-        .fs_configuration_descriptor = hid_configuration_descriptor, // HID configuration descriptor for full-speed and high-speed are the same
-        .hs_configuration_descriptor = hid_configuration_descriptor,
-        .qualifier_descriptor = NULL,
-#else
-        .configuration_descriptor = hid_configuration_descriptor,
-#endif // TUD_OPT_HIGH_SPEED
-    };
+static void boot_phase_done(boot_phase_t phase)
+{
+    boot_phase_end_us[phase] = esp_timer_get_time();
+}
 
-    ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
-    ESP_LOGI(LOG_TAG, "USB initialization DONE");
+static int64_t boot_phase_ms(boot_phase_t phase)
+{
+    return boot_phase_end_us[phase] / 1000;
+}
 
-    // SD card setup
+// one console line with when each phase finished; USB overlaps the card and files phases,
+// so these are times since reset rather than durations
+static void boot_phase_report(void)
+{
+    char line[160];
+    int length = 0;
+    for (int phase = 0; phase < BOOT_PHASE_COUNT && length < (int)sizeof(line); phase++)
+    {
+        length += snprintf(line + length, sizeof(line) - length, "%s%s %lld", phase > 0 ? ", " : "",
+                           boot_phase_names[phase], (long long)boot_phase_end_us[phase] / 1000);
+    }
+    ESP_LOGI(LOG_TAG, "Boot phases done at (ms after reset): %s", line);
+}
+
+// mount the card in the fastest bus mode from sd_bus_modes the board's pins and the card manage,
+// each mode having to pass a write and read back before it is kept
+static esp_err_t mount_sd_card(void)
+{
     esp_err_t ret;
-    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = true,
-        .max_files = 5,
-        .allocation_unit_size = 16 * 1024
-    };
-    const char mount_point[] = MOUNT_POINT;
     ESP_LOGI(LOG_TAG, "Initializing SD card");
 
-    // By default, SD card frequency is initialized to SDMMC_FREQ_DEFAULT (20MHz)
-    // For setting a specific frequency, use host.max_freq_khz (range 400kHz - 40MHz for SDMMC)
-    // Example: for fixed frequency of 10MHz, use host.max_freq_khz = 10000;
-    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-
     // For SoCs where the SD power can be supplied both via an internal or external (e.g. on-board LDO) power supply.
     // When using specific IO pins (which can be used for ultra high-speed SDMMC) to connect to the SD card
     // and the internal LDO power supply, we need to initialize the power supply first.
@@ -250,128 +451,380 @@ void app_main(void)
     ret = sd_pwr_ctrl_new_on_chip_ldo(&ldo_config, &pwr_ctrl_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(LOG_TAG, "Failed to create a new on-chip LDO power control driver");
-        return;
+        return ret;
     }
-    host.pwr_ctrl_handle = pwr_ctrl_handle;
 #endif
 
-    // This initializes the slot without card detect (CD) and write protect (WP) signals.
-    // Modify slot_config.gpio_cd and slot_config.gpio_wp if your board has these signals.
-    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
+    const int mode_count = sizeof(sd_bus_modes) / sizeof(sd_bus_modes[0]);
+    for (int i = 0; i < mode_count; i++)
+    {
+        const sd_bus_mode_t *mode = &sd_bus_modes[i];
+        if (mode->width == 4 && (PIN_SD_MMC_D1 < 0 || PIN_SD_MMC_D2 < 0 || PIN_SD_MMC_D3 < 0))
+        {
+            continue;
+        }
 
-    // Set bus width to use:
-    slot_config.width = 1;
+        // only the last resort may format: a card misread at too high a clock must not be wiped
+        esp_vfs_fat_sdmmc_mount_config_t mount_config = {
+            .format_if_mount_failed = i == mode_count - 1,
+            .max_files = 5,
+            .allocation_unit_size = 16 * 1024
+        };
 
-    // On chips where the GPIOs used for SD card can be configured, set them in
-    // the slot_config structure:
+        sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+        host.max_freq_khz = mode->freq_khz;
+#if CONFIG_EXAMPLE_SD_PWR_CTRL_LDO_INTERNAL_IO
+        host.pwr_ctrl_handle = pwr_ctrl_handle;
+#endif
+
+        // This initializes the slot without card detect (CD) and write protect (WP) signals.
+        // Modify slot_config.gpio_cd and slot_config.gpio_wp if your board has these signals.
+        sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
+        slot_config.width = mode->width;
+
+        // On chips where the GPIOs used for SD card can be configured, set them in
+        // the slot_config structure:
 #ifdef CONFIG_SOC_SDMMC_USE_GPIO_MATRIX
-    slot_config.clk = PIN_SD_MMC_CLK;
-    slot_config.cmd = PIN_SD_MMC_CMD;
-    slot_config.d0 = PIN_SD_MMC_D0;
+        slot_config.clk = PIN_SD_MMC_CLK;
+        slot_config.cmd = PIN_SD_MMC_CMD;
+        slot_config.d0 = PIN_SD_MMC_D0;
+        if (mode->width == 4)
+        {
+            slot_config.d1 = PIN_SD_MMC_D1;
+            slot_config.d2 = PIN_SD_MMC_D2;
+            slot_config.d3 = PIN_SD_MMC_D3;
+        }
 #endif  // CONFIG_SOC_SDMMC_USE_GPIO_MATRIX
 
-    // Enable internal pullups on enabled pins. The internal pullups
-    // are insufficient however, please make sure 10k external pullups are
-    // connected on the bus. This is for debug / example purpose only.
-    slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+        // Enable internal pullups on enabled pins. The internal pullups
+        // are insufficient however, please make sure 10k external pullups are
+        // connected on the bus. This is for debug / example purpose only.
+        slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
 
-    ESP_LOGI(LOG_TAG, "Mounting filesystem");
-    ret = esp_vfs_fat_sdmmc_mount(mount_point, &host, &slot_config, &mount_config, &card);
+        ESP_LOGI(LOG_TAG, "Mounting filesystem, %d-bit at up to %d kHz", mode->width, mode->freq_khz);
+        ret = esp_vfs_fat_sdmmc_mount(MOUNT_POINT, &host, &slot_config, &mount_config, &card);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW(LOG_TAG, "Card did not mount in this mode (%s)", esp_err_to_name(ret));
+            continue;
+        }
 
-    if (ret != ESP_OK) {
-        if (ret == ESP_FAIL) {
-            ESP_LOGE(LOG_TAG, "Failed to mount filesystem");
-        } else {
-            ESP_LOGE(LOG_TAG, "Failed to initialize the card (%s). "
-                     "Make sure SD card lines have pull-up resistors in place.", esp_err_to_name(ret));
+        ret = bench_throughput(SD_PROBE_FILENAME, SD_PROBE_SIZE, bench_now_us, &sd_write_kbps, &sd_read_kbps);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW(LOG_TAG, "Card failed the probe in this mode (%s)", esp_err_to_name(ret));
+            esp_vfs_fat_sdcard_unmount(MOUNT_POINT, card);
+            continue;
         }
-        return;
+
+        ESP_LOGI(LOG_TAG, "Filesystem mounted, %d-bit at %d kHz: write %lu KB/s, read %lu KB/s",
+                 1 << card->log_bus_width, card->real_freq_khz,
+                 (unsigned long)sd_write_kbps, (unsigned long)sd_read_kbps);
+        sd_host = host;
+        sd_slot_config = slot_config;
+        sdmmc_card_print_info(stdout, card);
+        return ESP_OK;
+    }
+
+    ESP_LOGE(LOG_TAG, "Failed to mount the SD card in any mode. "
+             "Make sure SD card lines have pull-up resistors in place.");
+    return ESP_FAIL;
+}
+
+// time the old and new dictionary, resume and logging paths on this card, for every
+// dictionary that is on it both as text and packed
+static void run_benchmarks(void)
+{
+    mkdir(BENCH_DIRECTORY, 0777);
+    bench_print_header();
+    for (int digits = 3; digits <= 6; digits++)
+    {
+        char name[8];
+        char text_path[32];
+        char dict_path[32];
+        char compressed_path[32];
+        snprintf(name, sizeof(name), "PIN%d", digits);
+        snprintf(text_path, sizeof(text_path), MOUNT_POINT"/%s.TXT", name);
+        snprintf(dict_path, sizeof(dict_path), MOUNT_POINT"/%s.DIC", name);
+        snprintf(compressed_path, sizeof(compressed_path), MOUNT_POINT"/%sZ.DIC", name);
+
+        struct stat st;
+        if (stat(text_path, &st) != 0 || stat(dict_path, &st) != 0)
+        {
+            continue;
+        }
+
+        const bench_config_t config = {
+            .name = name,
+            .text_path = text_path,
+            .dict_path = dict_path,
+            .compressed_path = stat(compressed_path, &st) == 0 ? compressed_path : NULL,
+            .work_dir = BENCH_DIRECTORY,
+            .appends = BENCH_APPENDS,
+            .now_us = bench_now_us,
+        };
+        bench_run(&config);
+    }
+}
+
+// open the selected dictionaries and the run state kept on the card, closing what was opened on failure
+static esp_err_t open_run_files(void)
+{
+    settings_defaults(&settings);
+    settings_load(&settings, SETTINGS_FILENAME);
+
+    // open the selected dictionaries, tried one after the other
+    if (dict_chain_open(&chain, settings.dictionary, open_dictionary) != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open dictionaries %s for reading", settings.dictionary);
+        return ESP_FAIL;
+    }
+
+    // passcodes already tried, skipped whichever dictionary lists them
+    if (visited_open(&visited, visited_filename, chain.lengths) != ESP_OK)
+    {
+        dict_chain_close(&chain);
+        return ESP_FAIL;
+    }
+    chain.visited = &visited;
+
+    // resume point, a single small read however far the run has got
+    if (checkpoint_open(&checkpoint, checkpoint_filename) != ESP_OK)
+    {
+        visited_close(&visited);
+        dict_chain_close(&chain);
+        return ESP_FAIL;
+    }
+
+    if (journal_open(&journal, &journal_config) != ESP_OK)
+    {
+        checkpoint_close(&checkpoint);
+        visited_close(&visited);
+        dict_chain_close(&chain);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+// mount the card and open the run's files on the second core while app_main brings USB up
+static void card_init_task(void *arg)
+{
+#if PIN_SD_POWER >= 0
+    gpio_reset_pin(PIN_SD_POWER);
+    gpio_set_direction(PIN_SD_POWER, GPIO_MODE_OUTPUT);
+    gpio_set_level(PIN_SD_POWER, SD_POWER_ON_LEVEL);
+    vTaskDelay(pdMS_TO_TICKS(SD_POWER_UP_MS));
+#endif
+
+    if (mount_sd_card() != ESP_OK)
+    {
+        xEventGroupSetBits(boot_events, BOOT_FILES_FAILED);
+        vTaskDelete(NULL);
+    }
+    boot_phase_done(BOOT_PHASE_CARD);
+
+    if (gpio_get_level(GPIO_NUM_0) == 0)
+    {
+        ESP_LOGI(LOG_TAG, "BOOT held, running benchmarks");
+        run_benchmarks();
+    }
+
+    if (open_run_files() != ESP_OK)
+    {
+        xEventGroupSetBits(boot_events, BOOT_FILES_FAILED);
+        vTaskDelete(NULL);
     }
-    ESP_LOGI(LOG_TAG, "Filesystem mounted");
-    sdmmc_card_print_info(stdout, card);
+    boot_phase_done(BOOT_PHASE_FILES);
 
-    // main application settings
-    const int attempt_limit_timeout_doubled = 200;  // after this many attempts, timeout is doubled
-    const int attempt_limit_no_timeouts = 1;        // you get this many attempts before hitting the timeout
-    const int leeway_secs = 5;                      // allow for a few extra seconds to align times
-    int timeout_seconds = 960 + leeway_secs;        // number of seconds to wait after timeout hit
+    xEventGroupSetBits(boot_events, BOOT_FILES_READY);
+    vTaskDelete(NULL);
+}
 
-    // configure status LED
-    gpio_reset_pin(LED_GPIO);
-    gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
+// main application entry point
+void app_main(void)
+{
+    boot_phase_done(BOOT_PHASE_APP);
 
-    // start with status LED illuminated to show it is configuring, when configured it will turn off
-    gpio_set_level(LED_GPIO, 1);
+    // initialize BOOT button GPIO, held at power up it runs the storage benchmarks
+    const gpio_config_t boot_button_config = {
+        .pin_bit_mask = BIT64(GPIO_NUM_0),
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_DISABLE,
+        .pull_up_en = true,
+        .pull_down_en = false,
+    };
+    ESP_ERROR_CHECK(gpio_config(&boot_button_config));
 
-    // continue where we left off by reading the last tested passcode from the log file
-    int starting_passcode = 0;
-    read_last_passcode(&starting_passcode);
+    // status LED steady on while configuring, the RMT plays the patterns from here on
+    ESP_ERROR_CHECK(status_led_init(LED_GPIO));
+    status_led_set(STATUS_LED_CONFIGURING);
+
+#if CONFIG_PM_ENABLE
+    // scale the CPU down during lockouts. Automatic light sleep would stop the USB controller and drop
+    // the HID link, so it stays off
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = IDLE_CPU_FREQ_MHZ,
+        .light_sleep_enable = false,
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "attempt", &attempt_pm_lock));
+    ESP_ERROR_CHECK(esp_pm_lock_acquire(attempt_pm_lock));
+#endif
 
-    // open passcode dictionary file
-    FILE *pinlist = fopen(MOUNT_POINT"/PIN4.TXT", "r");
-    if (pinlist == NULL)
+    // the card and USB have nothing to wait on each other for, so bring them up side by side
+    boot_events = xEventGroupCreate();
+    if (boot_events == NULL
+        || xTaskCreatePinnedToCore(card_init_task, "card_init", CARD_INIT_TASK_STACK_SIZE, NULL,
+                                   CARD_INIT_TASK_PRIORITY, NULL, CARD_INIT_TASK_CORE) != pdPASS)
     {
-        ESP_LOGE(LOG_TAG, "Failed to open pinlist file for reading");
+        ESP_LOGE(LOG_TAG, "Failed to start card initialization");
+        status_led_set(STATUS_LED_ERROR);
         return;
     }
 
-    // skip through the file to find the starting passcode (from where we left off)
-    int passcode = 0;
-    int num_passcodes_tried = 0;
-    do
+    ESP_LOGI(LOG_TAG, "USB initialization");
+    const tinyusb_config_t tusb_cfg = {
+        .device_descriptor = NULL,
+        .string_descriptor = hid_string_descriptor,
+        .string_descriptor_count = sizeof(hid_string_descriptor) / sizeof(hid_string_descriptor[0]),
+        .external_phy = false,
+#if (TUD_OPT_HIGH_SPEED)
+        .fs_configuration_descriptor = hid_configuration_descriptor, // HID configuration descriptor for full-speed and high-speed are the same
+        .hs_configuration_descriptor = hid_configuration_descriptor,
+        .qualifier_descriptor = NULL,
+#else
+        .configuration_descriptor = hid_configuration_descriptor,
+#endif // TUD_OPT_HIGH_SPEED
+    };
+
+    ESP_ERROR_CHECK(event_log_init());
+    ESP_ERROR_CHECK(usb_link_init());
+    ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
+    ESP_ERROR_CHECK(status_link_init());
+    ESP_ERROR_CHECK(hid_transmitter_init(HID_BUSY_RETRY_US));
+    ESP_ERROR_CHECK(hid_latency_init());
+    ESP_LOGI(LOG_TAG, "USB initialization DONE");
+    boot_phase_done(BOOT_PHASE_USB);
+
+    // the host enumerates the device while the card task is still busy
+    EventBits_t bits = xEventGroupWaitBits(boot_events, BOOT_FILES_READY | BOOT_FILES_FAILED,
+                                           pdFALSE, pdFALSE, portMAX_DELAY);
+    if (bits & BOOT_FILES_FAILED)
+    {
+        status_led_set(STATUS_LED_ERROR);
+        return;
+    }
+
+    // continue where we left off
+    engine_t engine = {
+        .hid = &usb_hid_sink,
+        .clock = &esp_clock,
+        .storage = &storage_task_backend,
+        .monitor = &status_link_monitor,
+        .visited = &visited,
+    };
+    engine_resume(&engine, &chain, &checkpoint, passcode_log_filename);
+
+    // jump straight to the starting passcode
+    if (dict_chain_seek(&chain, engine.starting_index) != ESP_OK)
     {
-        fscanf(pinlist, "%d", &passcode);
-        num_passcodes_tried++;
-    } while (passcode != starting_passcode);
-    ESP_LOGI(LOG_TAG, "Previous attempts: %d", num_passcodes_tried);
-
-    // get cracking (observing timeouts etc)...
-    int attempts = 0;
-    int consecutive_attempts = 0;
-    while (!feof(pinlist))
+        ESP_LOGE(LOG_TAG, "Failed to seek to passcode %lu", (unsigned long)engine.starting_index);
+        status_led_set(STATUS_LED_ERROR);
+        return;
+    }
+    boot_phase_done(BOOT_PHASE_RESUME);
+    boot_phase_report();
+
+    // open this boot's part of the journal with how the card came up and how long startup took,
+    // so a slow or flaky card or a slow recovery after a brownout shows up before a long run
+    journal_record_t session = {
+        .type = JOURNAL_RECORD_SESSION,
+        .sd_freq_khz = card->real_freq_khz,
+        .sd_bus_width = 1 << card->log_bus_width,
+        .reset_reason = esp_reset_reason(),
+        .sd_write_kbps = sd_write_kbps > UINT16_MAX ? UINT16_MAX : sd_write_kbps,
+        .sd_read_kbps = sd_read_kbps > UINT16_MAX ? UINT16_MAX : sd_read_kbps,
+    };
+    journal_append(&journal, &session);
+    journal_record_t boot = { .type = JOURNAL_RECORD_BOOT };
+    journal_boot_set_ms(&boot, JOURNAL_BOOT_USB, boot_phase_ms(BOOT_PHASE_USB));
+    journal_boot_set_ms(&boot, JOURNAL_BOOT_CARD, boot_phase_ms(BOOT_PHASE_CARD));
+    journal_boot_set_ms(&boot, JOURNAL_BOOT_FILES, boot_phase_ms(BOOT_PHASE_FILES));
+    journal_boot_set_ms(&boot, JOURNAL_BOOT_RESUMED, boot_phase_ms(BOOT_PHASE_RESUME));
+    journal_append(&journal, &boot);
+
+    // optionally time how fast the host answers keystrokes before the run starts
+    hid_latency_histogram_t latency;
+    bool latency_measured = false;
+    if (settings.latency_probes > 0)
     {
-        if (tud_mounted())
+        if (usb_wait_ready(NULL))
         {
-            // try passcode and read next passcode from file
-            send_passcode(passcode);
-            fscanf(pinlist, "%d", &passcode);
-            attempts++;
-            consecutive_attempts++;
-
-            if (attempts == attempt_limit_timeout_doubled)
-            {
-                attempts = 0;
-                timeout_seconds *= 2;
-            }
-            else if (consecutive_attempts < attempt_limit_no_timeouts)
-            {
-                // no timeout required, so just go ahead and try next pincode (after a second grace period)
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                continue;
-            }
-            vTaskDelay(pdMS_TO_TICKS(timeout_seconds * 1000));
-            consecutive_attempts = 0;
+            // a host that only just attached may drop the first keystrokes
+            vTaskDelay(pdMS_TO_TICKS(SCHEDULE_GRACE_PERIOD_US / 1000));
+        }
+        if (hid_latency_measure(settings.latency_probes, &latency) == ESP_OK)
+        {
+            latency_measured = true;
+            journal_record_t latency_record = {
+                .type = JOURNAL_RECORD_LATENCY,
+                .latency_samples = latency.samples > UINT16_MAX ? UINT16_MAX : latency.samples,
+                .latency_p50_ms = hid_latency_percentile_us(&latency, 50) / 1000,
+                .latency_p95_ms = hid_latency_percentile_us(&latency, 95) / 1000,
+                .latency_max_ms = latency.max_us / 1000 > UINT16_MAX ? UINT16_MAX : latency.max_us / 1000,
+            };
+            journal_append(&journal, &latency_record);
         }
-
-        // powered, but HID not initialised yet, give it some more time
-        gpio_set_level(LED_GPIO, 1);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        gpio_set_level(LED_GPIO, 0);
-        vTaskDelay(pdMS_TO_TICKS(100));
     }
+    journal_commit(&journal);
 
-    // tried every passcode in the dictionary file, flash LED to indicate done
-    while(1)
+    // key timing for this target, a calibrated profile allows for the latency just measured
+    key_timing = hid_timing_default;
+    if (strcmp(settings.key_timing, HID_TIMING_PROFILE_CALIBRATED) == 0)
     {
-        for (int i = 0; i < 3; i++)
+        if (latency_measured)
         {
-            gpio_set_level(LED_GPIO, 1);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            gpio_set_level(LED_GPIO, 0);
-            vTaskDelay(pdMS_TO_TICKS(100));
+            hid_timing_calibrate(&key_timing, hid_latency_percentile_us(&latency, 95), HID_POLL_INTERVAL_MS * 1000);
         }
-        vTaskDelay(pdMS_TO_TICKS(2000));
+        else
+        {
+            ESP_LOGW(LOG_TAG, "No latency measured to calibrate the key timing, set latency_probes; using the default");
+        }
+    }
+    else if (hid_timing_profile(settings.key_timing, &key_timing) != ESP_OK)
+    {
+        ESP_LOGW(LOG_TAG, "Unknown key timing '%s', using the default", settings.key_timing);
+    }
+    ESP_LOGI(LOG_TAG, "Key timing: hold %lu us, gap %lu us, %lu us after Enter", (unsigned long)key_timing.key_hold_us,
+             (unsigned long)key_timing.key_gap_us, (unsigned long)key_timing.enter_settle_us);
+    hid_stream_key(&enter_stream, HID_STREAM_KEY_ENTER, &key_timing, key_timing.enter_settle_us);
+    hid_stream_clear(&clear_stream, &key_timing);
+
+    // hand the files over to the storage task, from here on the attempt loop never waits on the card
+    const storage_config_t storage_config = {
+        .chain = &chain,
+        .journal = &journal,
+        .checkpoint = &checkpoint,
+        .visited = &visited,
+        .card_power = sd_card_power,
+    };
+    ESP_ERROR_CHECK(storage_task_start(&storage_config));
+
+    // status LED off, configured and running
+    status_led_set(STATUS_LED_RUNNING);
+
+    esp_err_t ret = engine_run(&engine);
+    storage_task_stop();
+    if (ret != ESP_OK)
+    {
+        // a damaged dictionary must not pass for a finished run
+        status_led_set(STATUS_LED_ERROR);
+        return;
     }
 
-    fclose(pinlist);
+    // tried every passcode in the dictionaries and the rest of their keyspaces. The LED keeps flashing
+    // on its own, so the main task can end here
+    status_led_set(STATUS_LED_DONE);
 }
@@ -0,0 +1,71 @@
+#include "schedule.h"
+
+const schedule_rule_t schedule_default_rules[] = {
+    // first attempt, attempts per lockout, lockout seconds, doubling attempts
+    { 0, 1, 960 + SCHEDULE_LEEWAY_SECONDS, 200 },
+};
+
+const size_t schedule_default_rule_count = sizeof(schedule_default_rules) / sizeof(schedule_default_rules[0]);
+
+void schedule_init(schedule_t *schedule, const schedule_rule_t *rules, size_t rule_count)
+{
+    *schedule = (schedule_t) {
+        .rules = rules,
+        .rule_count = rule_count,
+    };
+}
+
+void schedule_restore(schedule_t *schedule, uint32_t attempts, uint32_t window_attempts,
+                      int64_t lockout_us, int64_t now_us)
+{
+    schedule->attempts = attempts;
+    schedule->window_attempts = window_attempts;
+    schedule->lockout_us = lockout_us;
+    schedule->next_attempt_us = lockout_us > 0 ? now_us + lockout_us : 0;
+}
+
+// rule covering the attempt made after `attempts` earlier ones
+static const schedule_rule_t *schedule_rule_for(const schedule_t *schedule, uint32_t attempts)
+{
+    const schedule_rule_t *rule = &schedule->rules[0];
+    for (size_t i = 1; i < schedule->rule_count && schedule->rules[i].first_attempt <= attempts; i++)
+    {
+        rule = &schedule->rules[i];
+    }
+    return rule;
+}
+
+int64_t schedule_attempt_made(schedule_t *schedule, int64_t submitted_us)
+{
+    const schedule_rule_t *rule = schedule_rule_for(schedule, schedule->attempts);
+    schedule->attempts++;
+    schedule->window_attempts++;
+
+    uint32_t rule_attempts = schedule->attempts - rule->first_attempt;
+    if (rule->lockout_seconds == 0 || schedule->window_attempts < rule->attempts_per_lockout)
+    {
+        // no timeout required, so just go ahead and try next pincode (after a second grace period)
+        schedule->lockout_us = 0;
+        schedule->next_attempt_us = submitted_us + SCHEDULE_GRACE_PERIOD_US;
+        return schedule->next_attempt_us;
+    }
+
+    uint32_t doublings = rule->doubling_attempts > 0 ? rule_attempts / rule->doubling_attempts : 0;
+    if (doublings > SCHEDULE_MAX_DOUBLINGS)
+    {
+        doublings = SCHEDULE_MAX_DOUBLINGS;
+    }
+    schedule->window_attempts = 0;
+    schedule->lockout_us = ((int64_t)rule->lockout_seconds * 1000000) << doublings;
+    schedule->next_attempt_us = submitted_us + schedule->lockout_us;
+    return schedule->next_attempt_us;
+}
+
+int64_t schedule_link_restored(schedule_t *schedule, int64_t now_us)
+{
+    if (schedule->next_attempt_us < now_us + SCHEDULE_GRACE_PERIOD_US)
+    {
+        schedule->next_attempt_us = now_us + SCHEDULE_GRACE_PERIOD_US;
+    }
+    return schedule->next_attempt_us;
+}
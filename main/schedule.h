@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Lockout schedule
+ *
+ * The target's lockout policy is described by a table of rules. Each rule
+ * covers the attempts from its first_attempt up to the next rule's: every
+ * attempts_per_lockout attempts the target locks you out for
+ * lockout_seconds, doubling every doubling_attempts attempts into the rule.
+ *
+ * Time is kept as absolute deadlines in 64 bit microseconds on the engine
+ * clock (esp_timer on the device), so waiting never accumulates drift and
+ * lockouts of any length fit.
+ */
+
+#define SCHEDULE_LEEWAY_SECONDS                 5       // allow for a few extra seconds to align times
+#define SCHEDULE_GRACE_PERIOD_US                1000000 // pause between attempts that do not hit the timeout
+#define SCHEDULE_MAX_DOUBLINGS                  24      // lockouts stop growing here, far beyond any real run
+
+typedef struct {
+    uint32_t first_attempt;             // number of attempts made before this rule applies
+    uint32_t attempts_per_lockout;      // you get this many attempts before hitting the timeout
+    uint32_t lockout_seconds;           // length of the timeout
+    uint32_t doubling_attempts;         // after this many attempts the timeout is doubled, 0 for never
+} schedule_rule_t;
+
+typedef struct {
+    const schedule_rule_t *rules;       // sorted by first_attempt, the first one starting at 0
+    size_t rule_count;
+    uint32_t attempts;                  // attempts made under the schedule
+    uint32_t window_attempts;           // attempts since the last timeout
+    int64_t lockout_us;                 // timeout started by the last attempt, 0 if it did not hit one
+    int64_t next_attempt_us;            // clock time the next attempt may be submitted at
+} schedule_t;
+
+// the Android lock screen: one attempt per 960 second timeout, doubling every 200 attempts
+extern const schedule_rule_t schedule_default_rules[];
+extern const size_t schedule_default_rule_count;
+
+void schedule_init(schedule_t *schedule, const schedule_rule_t *rules, size_t rule_count);
+
+// pick up a schedule saved by an earlier run. The time spent powered off is unknown, so a timeout
+// that was in progress is waited out again in full from `now_us`
+void schedule_restore(schedule_t *schedule, uint32_t attempts, uint32_t window_attempts,
+                      int64_t lockout_us, int64_t now_us);
+
+// account for an attempt submitted at `submitted_us`, returns the deadline for the next attempt
+int64_t schedule_attempt_made(schedule_t *schedule, int64_t submitted_us);
+
+// the link to the target came back at `now_us` (enumerated again or woken from suspend): hold the
+// next attempt for the grace period, since a host that just attached may drop the first keystrokes.
+// Returns the deadline for the next attempt
+int64_t schedule_link_restored(schedule_t *schedule, int64_t now_us);
@@ -0,0 +1,154 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "esp_log.h"
+#include "settings.h"
+
+#define LOG_TAG                "settings"
+#define SETTINGS_LINE_MAX      128
+
+typedef enum {
+    SETTINGS_STRING,                    // char[SETTINGS_VALUE_MAX]
+    SETTINGS_UINT,                      // uint32_t, decimal
+} settings_type_t;
+
+typedef struct {
+    const char *key;
+    size_t offset;                      // of the value in settings_t
+    settings_type_t type;
+} settings_key_t;
+
+static const settings_key_t settings_keys[] = {
+    { "dictionary", offsetof(settings_t, dictionary), SETTINGS_STRING },
+    { "latency_probes", offsetof(settings_t, latency_probes), SETTINGS_UINT },
+    { "key_timing", offsetof(settings_t, key_timing), SETTINGS_STRING },
+};
+
+// store `value` for `key`. Returns ESP_ERR_INVALID_SIZE, leaving the setting as it was, if a string
+// does not fit, and ESP_ERR_INVALID_ARG if `value` is not valid for the key's type
+static esp_err_t settings_set(settings_t *settings, const settings_key_t *key, const char *value)
+{
+    void *target = (char *)settings + key->offset;
+    if (key->type == SETTINGS_STRING)
+    {
+        // a cut short value could still look valid, e.g. a dictionary chain missing its tail
+        char stored[SETTINGS_VALUE_MAX];
+        if (snprintf(stored, sizeof(stored), "%s", value) >= (int)sizeof(stored))
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(target, stored, sizeof(stored));
+        return ESP_OK;
+    }
+
+    char *end;
+    unsigned long number = strtoul(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || number > UINT32_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *(uint32_t *)target = number;
+    return ESP_OK;
+}
+
+void settings_defaults(settings_t *settings)
+{
+    memset(settings, 0, sizeof(*settings));
+    strcpy(settings->dictionary, "PIN4.DIC");
+    strcpy(settings->key_timing, "default");
+}
+
+// strip leading and trailing whitespace in place
+static char *settings_trim(char *text)
+{
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+    size_t length = strlen(text);
+    while (length > 0 && isspace((unsigned char)text[length - 1]))
+    {
+        text[--length] = '\0';
+    }
+    return text;
+}
+
+esp_err_t settings_load(settings_t *settings, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char line[SETTINGS_LINE_MAX];
+    unsigned long line_no = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        line_no++;
+
+        // the rest of an overlong line would otherwise be read as a line of its own
+        size_t length = strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n' && !feof(f))
+        {
+            if (*settings_trim(line) != '#')
+            {
+                ESP_LOGE(LOG_TAG, "%s:%lu: line too long, ignored", path, line_no);
+            }
+            int c;
+            while ((c = fgetc(f)) != EOF && c != '\n')
+            {
+            }
+            continue;
+        }
+
+        char *key = settings_trim(line);
+        if (*key == '\0' || *key == '#')
+        {
+            continue;
+        }
+
+        char *equals = strchr(key, '=');
+        if (equals == NULL)
+        {
+            ESP_LOGW(LOG_TAG, "%s:%lu: expected key=value", path, line_no);
+            continue;
+        }
+        *equals = '\0';
+        key = settings_trim(key);
+        char *value = settings_trim(equals + 1);
+
+        size_t i;
+        for (i = 0; i < sizeof(settings_keys) / sizeof(settings_keys[0]); i++)
+        {
+            if (strcmp(key, settings_keys[i].key) == 0)
+            {
+                esp_err_t ret = settings_set(settings, &settings_keys[i], value);
+                if (ret == ESP_OK)
+                {
+                    ESP_LOGI(LOG_TAG, "%s = %s", key, value);
+                }
+                else if (ret == ESP_ERR_INVALID_SIZE)
+                {
+                    ESP_LOGE(LOG_TAG, "%s:%lu: value for %s longer than %d characters, ignored",
+                             path, line_no, key, SETTINGS_VALUE_MAX - 1);
+                }
+                else
+                {
+                    ESP_LOGW(LOG_TAG, "%s:%lu: bad value '%s' for %s", path, line_no, value, key);
+                }
+                break;
+            }
+        }
+        if (i == sizeof(settings_keys) / sizeof(settings_keys[0]))
+        {
+            ESP_LOGW(LOG_TAG, "%s:%lu: unknown setting '%s'", path, line_no, key);
+        }
+    }
+    fclose(f);
+
+    return ESP_OK;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Run settings read from a text file on the card
+ *
+ * One `key=value` per line; blank lines and lines starting with '#' are
+ * ignored, as is whitespace around keys and values. Anything missing keeps
+ * its default, so the file is optional. For example:
+ *
+ *     # RABBIT.CFG
+ *     dictionary=LIKELY.TXT,PIN6.DIC
+ *     latency_probes=20
+ *     key_timing=calibrated
+ */
+
+#define SETTINGS_VALUE_MAX     64
+
+typedef struct {
+    char dictionary[SETTINGS_VALUE_MAX];    // dictionary file names on the card, packed (.DIC) or text (.TXT),
+                                            // comma separated and tried in order
+    uint32_t latency_probes;                // lock key round trips to time at startup, 0 to skip (see hid_latency.h)
+    char key_timing[SETTINGS_VALUE_MAX];    // key timing profile, or "calibrated" from the latency (see hid_timing.h)
+} settings_t;
+
+void settings_defaults(settings_t *settings);
+
+// apply the settings in `path` on top of what is already in `settings`.
+// Returns ESP_ERR_NOT_FOUND, leaving `settings` untouched, if there is no such file
+esp_err_t settings_load(settings_t *settings, const char *path);
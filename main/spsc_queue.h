@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring of fixed size items
+ *
+ * Exactly one task may push and exactly one (other) task may pop. head is
+ * only written by the producer and tail only by the consumer, so the two
+ * never contend and neither side ever takes a lock or disables interrupts.
+ * Capacity must be a power of two.
+ */
+typedef struct {
+    uint8_t *buffer;                    // capacity * item_size bytes
+    size_t item_size;
+    size_t capacity;
+    atomic_size_t head;                 // next slot to write, producer owned
+    atomic_size_t tail;                 // next slot to read, consumer owned
+} spsc_queue_t;
+
+static inline void spsc_queue_init(spsc_queue_t *queue, void *buffer, size_t item_size, size_t capacity)
+{
+    queue->buffer = buffer;
+    queue->item_size = item_size;
+    queue->capacity = capacity;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+// number of items waiting, exact from either side's point of view for its own end
+static inline size_t spsc_queue_count(spsc_queue_t *queue)
+{
+    return atomic_load_explicit(&queue->head, memory_order_acquire)
+         - atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
+
+// producer side, returns false if the queue is full
+static inline bool spsc_queue_push(spsc_queue_t *queue, const void *item)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == queue->capacity)
+    {
+        return false;
+    }
+
+    memcpy(&queue->buffer[(head & (queue->capacity - 1)) * queue->item_size], item, queue->item_size);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+// consumer side, returns false if the queue is empty
+static inline bool spsc_queue_pop(spsc_queue_t *queue, void *item)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail)
+    {
+        return false;
+    }
+
+    memcpy(item, &queue->buffer[(tail & (queue->capacity - 1)) * queue->item_size], queue->item_size);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Status channel wire format
+ *
+ * While a host has the CDC-ACM port open the firmware sends a
+ * status_frame_t every STATUS_PERIOD_MS and after every attempt, little
+ * endian and back to back. A reader that joins mid-stream finds the next
+ * frame by its magic and checks it with the CRC. Single command bytes go
+ * the other way.
+ */
+
+#define STATUS_FRAME_SIZE      64
+#define STATUS_FRAME_MAGIC     0x54535252      // "RRST"
+#define STATUS_VERSION         1
+#define STATUS_PERIOD_MS       1000
+
+// commands, one byte each, anything else is ignored
+#define STATUS_CMD_PAUSE       'p'             // finish the attempt in progress, then hold off
+#define STATUS_CMD_RESUME      'r'
+#define STATUS_CMD_STATUS      's'             // send a frame now
+
+#define STATUS_FLAG_PAUSED     0x01
+#define STATUS_FLAG_DONE       0x02            // every passcode has been tried
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;                      // STATUS_FRAME_SIZE
+    uint32_t sequence;                  // frames sent since boot
+    uint32_t index;                     // chain index of the next passcode to try
+    uint32_t attempts_made;             // attempts submitted since boot
+    uint32_t schedule_attempts;         // schedule state, as in the checkpoint
+    uint32_t schedule_window_attempts;
+    uint32_t durable_wait_us;           // how long the last attempt waited for its journal record to sync
+    int64_t uptime_us;                  // when the frame was sent
+    int64_t lockout_us;                 // length of the timeout in progress, 0 if none
+    int64_t wait_us;                    // until the next attempt may go out, 0 if it is due
+    uint8_t flags;                      // STATUS_FLAG_*
+    uint8_t reserved[3];
+    uint32_t crc32;                     // CRC32 of everything above
+} status_frame_t;
+
+_Static_assert(sizeof(status_frame_t) == STATUS_FRAME_SIZE, "status frames must be 64 bytes");
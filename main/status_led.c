@@ -0,0 +1,132 @@
+#include <stdbool.h>
+#include "esp_log.h"
+#include "driver/rmt_tx.h"
+#include "status_led.h"
+
+#define LOG_TAG                "status_led"
+#define STATUS_LED_MAX_STEPS   4
+#define STATUS_LED_MAX_TICKS   32767           // longest half of an RMT symbol
+#define STATUS_LED_TICKS_PER_MS (STATUS_LED_RESOLUTION_HZ / 1000)
+#define STATUS_LED_SYMBOLS     SOC_RMT_MEM_WORDS_PER_CHANNEL   // a looped pattern must fit the channel's memory
+
+typedef struct {
+    uint16_t on_ms;
+    uint16_t off_ms;
+} status_led_step_t;
+
+typedef struct {
+    status_led_step_t steps[STATUS_LED_MAX_STEPS];      // played in turn, then from the start; unused steps are 0
+    int level;                                          // for a steady state (no steps), the level to hold
+} status_led_pattern_t;
+
+static const status_led_pattern_t patterns[] = {
+    [STATUS_LED_OFF] = { .level = 0 },
+    [STATUS_LED_CONFIGURING] = { .level = 1 },
+    [STATUS_LED_WAITING] = { .steps = { { 100, 100 } } },
+    [STATUS_LED_RUNNING] = { .level = 0 },
+    [STATUS_LED_LOCKOUT] = { .steps = { { 50, 2950 } } },
+    [STATUS_LED_DONE] = { .steps = { { 100, 100 }, { 100, 100 }, { 100, 2100 } } },
+    [STATUS_LED_ERROR] = { .steps = { { 50, 50 } } },
+};
+
+static rmt_channel_handle_t channel;
+static rmt_encoder_handle_t encoder;
+static status_led_state_t current = STATUS_LED_OFF;
+
+// the pattern being looped, read by the hardware until the next status_led_set()
+static rmt_symbol_word_t symbols[STATUS_LED_SYMBOLS];
+static size_t half_count;               // symbol halves filled in
+
+// append `ticks` at `level`, split into halves the RMT can time
+static bool status_led_append(int level, uint32_t ticks)
+{
+    while (ticks > 0)
+    {
+        if (half_count >= 2 * STATUS_LED_SYMBOLS)
+        {
+            return false;
+        }
+        uint32_t chunk = ticks < STATUS_LED_MAX_TICKS ? ticks : STATUS_LED_MAX_TICKS;
+        rmt_symbol_word_t *symbol = &symbols[half_count / 2];
+        if (half_count % 2 == 0)
+        {
+            symbol->level0 = level;
+            symbol->duration0 = chunk;
+        }
+        else
+        {
+            symbol->level1 = level;
+            symbol->duration1 = chunk;
+        }
+        half_count++;
+        ticks -= chunk;
+    }
+    return true;
+}
+
+esp_err_t status_led_init(int gpio)
+{
+    const rmt_tx_channel_config_t channel_config = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_XTAL,    // keeps running, and keeps its rate, while power management scales the CPU
+        .resolution_hz = STATUS_LED_RESOLUTION_HZ,
+        .mem_block_symbols = STATUS_LED_SYMBOLS,
+        .trans_queue_depth = 1,
+    };
+    esp_err_t ret = rmt_new_tx_channel(&channel_config, &channel);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to claim an RMT channel");
+        return ret;
+    }
+    const rmt_copy_encoder_config_t encoder_config = {};
+    ret = rmt_new_copy_encoder(&encoder_config, &encoder);
+    if (ret == ESP_OK)
+    {
+        ret = rmt_enable(channel);
+    }
+    return ret;
+}
+
+void status_led_set(status_led_state_t state)
+{
+    if (channel == NULL || state == current)
+    {
+        return;
+    }
+    current = state;
+
+    // disabling aborts the pattern playing now, so its symbols can be rewritten
+    rmt_disable(channel);
+    rmt_encoder_reset(encoder);
+    rmt_enable(channel);
+
+    const status_led_pattern_t *pattern = &patterns[state];
+    half_count = 0;
+    rmt_transmit_config_t transmit_config = {
+        .loop_count = -1,
+    };
+    for (int i = 0; i < STATUS_LED_MAX_STEPS && pattern->steps[i].on_ms > 0; i++)
+    {
+        if (!status_led_append(1, pattern->steps[i].on_ms * STATUS_LED_TICKS_PER_MS)
+            || !status_led_append(0, pattern->steps[i].off_ms * STATUS_LED_TICKS_PER_MS))
+        {
+            ESP_LOGE(LOG_TAG, "Pattern %d does not fit", state);
+            return;
+        }
+    }
+    if (half_count == 0)
+    {
+        // a steady state: one short pulse at the level, which the pin then holds
+        status_led_append(pattern->level, 1);
+        transmit_config.loop_count = 0;
+        transmit_config.flags.eot_level = pattern->level;
+    }
+    if (half_count % 2 != 0)
+    {
+        // a zero duration would end the pattern, so pad the last symbol by a tick
+        status_led_append(symbols[half_count / 2].level0, 1);
+    }
+
+    rmt_transmit(channel, encoder, symbols, half_count / 2 * sizeof(symbols[0]), &transmit_config);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "esp_err.h"
+
+/**
+ * @brief Status LED patterns played by the RMT peripheral
+ *
+ * Each state is a blink pattern encoded once into RMT symbols and looped by
+ * the hardware, so no task wakes up to toggle the LED and a finished run can
+ * let the main task exit with the LED still saying so. Steady states are a
+ * single level held on the pin.
+ *
+ * Only one task may call status_led_set().
+ */
+
+#define STATUS_LED_RESOLUTION_HZ     160000  // RMT tick rate, XTAL 40 MHz / 250; halves of a symbol last up to 204 ms
+
+typedef enum {
+    STATUS_LED_OFF,
+    STATUS_LED_CONFIGURING,             // steady on: mounting the card and opening files
+    STATUS_LED_WAITING,                 // fast blink: waiting for the USB host
+    STATUS_LED_RUNNING,                 // off: typing attempts
+    STATUS_LED_LOCKOUT,                 // short blip every few seconds: waiting out a lockout
+    STATUS_LED_DONE,                    // three flashes and a pause: every passcode tried
+    STATUS_LED_ERROR,                   // flicker: startup failed, see the console
+} status_led_state_t;
+
+// claim an RMT channel for the LED on `gpio`, starting off
+esp_err_t status_led_init(int gpio);
+
+// switch to the pattern for `state`, does nothing if it is already playing
+void status_led_set(status_led_state_t state);
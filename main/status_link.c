@@ -0,0 +1,164 @@
+#include <stddef.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "tinyusb.h"
+#include "tusb_cdc_acm.h"
+#include "crc32.h"
+#include "status_link.h"
+
+#define LOG_TAG                "status"
+#define STATUS_LINK_RUNNING    BIT0            // clear while paused
+
+static TaskHandle_t status_task_handle;
+static EventGroupHandle_t run_state;
+
+// latest report from the engine, written by the attempt loop and read by the status task
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+static engine_status_t status;
+
+static uint32_t frames_sent;            // status task only
+
+// build a frame from the latest report and send it, if a host is listening
+static void status_link_send(void)
+{
+    if (!tud_cdc_n_connected(TINYUSB_CDC_ACM_0))
+    {
+        return;
+    }
+
+    engine_status_t snapshot;
+    taskENTER_CRITICAL(&status_lock);
+    snapshot = status;
+    taskEXIT_CRITICAL(&status_lock);
+
+    int64_t now_us = esp_timer_get_time();
+    status_frame_t frame = {
+        .magic = STATUS_FRAME_MAGIC,
+        .version = STATUS_VERSION,
+        .size = sizeof(frame),
+        .sequence = ++frames_sent,
+        .index = snapshot.index,
+        .attempts_made = snapshot.attempts_made,
+        .schedule_attempts = snapshot.schedule_attempts,
+        .schedule_window_attempts = snapshot.schedule_window_attempts,
+        .durable_wait_us = snapshot.durable_wait_us,
+        .uptime_us = now_us,
+        .lockout_us = snapshot.lockout_us,
+        .wait_us = snapshot.next_attempt_us > now_us ? snapshot.next_attempt_us - now_us : 0,
+    };
+    if ((xEventGroupGetBits(run_state) & STATUS_LINK_RUNNING) == 0)
+    {
+        frame.flags |= STATUS_FLAG_PAUSED;
+    }
+    if (snapshot.done)
+    {
+        frame.flags |= STATUS_FLAG_DONE;
+    }
+    frame.crc32 = crc32_update(0, &frame, offsetof(status_frame_t, crc32));
+
+    // a host that stopped reading only loses whole frames, it never holds the task up
+    if (tud_cdc_n_write_available(TINYUSB_CDC_ACM_0) < sizeof(frame))
+    {
+        return;
+    }
+    tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t *)&frame, sizeof(frame));
+    tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+}
+
+static void status_task(void *arg)
+{
+    for (;;)
+    {
+        // with nobody listening the task sleeps until the line state callback says a host opened the port
+        TickType_t period = tud_cdc_n_connected(TINYUSB_CDC_ACM_0) ? pdMS_TO_TICKS(STATUS_PERIOD_MS) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, period);
+        status_link_send();
+    }
+}
+
+// runs in the TinyUSB task when the host raises or drops DTR
+static void status_link_line_state(int itf, cdcacm_event_t *event)
+{
+    xTaskNotifyGive(status_task_handle);
+}
+
+// runs in the TinyUSB task
+static void status_link_rx(int itf, cdcacm_event_t *event)
+{
+    uint8_t commands[CONFIG_TINYUSB_CDC_RX_BUFSIZE];
+    size_t length = 0;
+    if (tinyusb_cdcacm_read(itf, commands, sizeof(commands), &length) != ESP_OK)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        switch (commands[i])
+        {
+        case STATUS_CMD_PAUSE:
+            ESP_LOGI(LOG_TAG, "Paused by host");
+            xEventGroupClearBits(run_state, STATUS_LINK_RUNNING);
+            break;
+        case STATUS_CMD_RESUME:
+            ESP_LOGI(LOG_TAG, "Resumed by host");
+            xEventGroupSetBits(run_state, STATUS_LINK_RUNNING);
+            break;
+        case STATUS_CMD_STATUS:
+            break;
+        default:
+            continue;
+        }
+        xTaskNotifyGive(status_task_handle);
+    }
+}
+
+esp_err_t status_link_init(void)
+{
+    run_state = xEventGroupCreate();
+    if (run_state == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    xEventGroupSetBits(run_state, STATUS_LINK_RUNNING);
+
+    if (xTaskCreate(status_task, "status", STATUS_LINK_TASK_STACK_SIZE, NULL,
+                    STATUS_LINK_TASK_PRIORITY, &status_task_handle) != pdPASS)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to create status task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    const tinyusb_config_cdcacm_t acm_config = {
+        .usb_dev = TINYUSB_USBDEV_0,
+        .cdc_port = TINYUSB_CDC_ACM_0,
+        .rx_unread_buf_sz = CONFIG_TINYUSB_CDC_RX_BUFSIZE,
+        .callback_rx = status_link_rx,
+        .callback_line_state_changed = status_link_line_state,
+    };
+    return tusb_cdc_acm_init(&acm_config);
+}
+
+static void status_link_report(void *ctx, const engine_status_t *report)
+{
+    taskENTER_CRITICAL(&status_lock);
+    status = *report;
+    taskEXIT_CRITICAL(&status_lock);
+    if (tud_cdc_n_connected(TINYUSB_CDC_ACM_0))
+    {
+        xTaskNotifyGive(status_task_handle);
+    }
+}
+
+static void status_link_wait_resumed(void *ctx)
+{
+    xEventGroupWaitBits(run_state, STATUS_LINK_RUNNING, pdFALSE, pdTRUE, portMAX_DELAY);
+}
+
+const engine_monitor_t status_link_monitor = {
+    .report = status_link_report,
+    .wait_resumed = status_link_wait_resumed,
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "esp_err.h"
+#include "engine.h"
+#include "status_format.h"
+
+/**
+ * @brief Live status and control over the USB CDC-ACM interface
+ *
+ * The engine reports its progress here after every attempt. A low priority
+ * task sends that snapshot as a status frame (see status_format.h) once a
+ * second and right after each report, but only while a host holds the port
+ * open; otherwise the task stays blocked until the port's line state
+ * changes, so nobody listening costs nothing, not even a wakeup. Commands arrive on the same port
+ * and a pause holds the engine just before it types its next passcode. None
+ * of this touches the SD card.
+ */
+
+#define STATUS_LINK_TASK_PRIORITY    2
+#define STATUS_LINK_TASK_STACK_SIZE  3072
+
+// set up the CDC-ACM port and start the status task, after tinyusb_driver_install()
+esp_err_t status_link_init(void);
+
+// the engine's monitor, reporting to and paused by the status link
+extern const engine_monitor_t status_link_monitor;
@@ -0,0 +1,367 @@
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "freertos/task.h"
+#include "spsc_queue.h"
+#include "storage_task.h"
+
+#define LOG_TAG                "storage"
+
+typedef enum {
+    STORAGE_REQUEST_ATTEMPT,
+    STORAGE_REQUEST_CHECKPOINT,
+    STORAGE_REQUEST_SUSPEND,
+    STORAGE_REQUEST_RESUME,
+    STORAGE_REQUEST_STOP,
+} storage_request_type_t;
+
+typedef struct {
+    storage_request_type_t type;
+    union {
+        journal_record_t record;
+        checkpoint_state_t checkpoint;
+    };
+} storage_request_t;
+
+typedef struct {
+    uint32_t index;
+    candidate_t candidate;
+    esp_err_t result;                   // not ESP_OK for the item ending the stream: ESP_ERR_NOT_FOUND
+                                        // after the last passcode, otherwise why the next could not be read
+} storage_passcode_t;
+
+static storage_config_t storage;
+static TaskHandle_t storage_task_handle;
+static TaskHandle_t attempt_task_handle;
+
+static spsc_queue_t passcode_queue;     // storage task -> attempt loop
+static spsc_queue_t request_queue;      // attempt loop -> storage task
+static storage_passcode_t passcode_buffer[STORAGE_PASSCODE_QUEUE_LEN];
+static storage_request_t request_buffer[STORAGE_REQUEST_QUEUE_LEN];
+
+static uint32_t attempts_queued;        // tickets handed out, attempt loop only
+static atomic_uint_fast32_t attempts_durable;
+static bool dict_exhausted;             // storage task only
+static bool card_suspended;             // storage task only
+static esp_err_t passcodes_end = ESP_OK;   // attempt loop only, result of the item that ended the stream
+static atomic_bool storage_stopped;
+static atomic_int storage_error;        // first write to the card that failed, ESP_OK if none; sticky
+
+// read ahead from the dictionaries until the passcode ring is full
+static void storage_fill_passcodes(void)
+{
+    bool pushed = false;
+    while (!dict_exhausted && spsc_queue_count(&passcode_queue) < STORAGE_PASSCODE_QUEUE_LEN)
+    {
+        storage_passcode_t item;
+        item.result = dict_chain_next(storage.chain, &item.index, &item.candidate);
+        if (item.result != ESP_OK)
+        {
+            dict_exhausted = true;
+        }
+        spsc_queue_push(&passcode_queue, &item);
+        pushed = true;
+    }
+
+    if (pushed)
+    {
+        xTaskNotifyGive(attempt_task_handle);
+    }
+}
+
+// remember the first failed write; from then on no attempt counts as durable and every
+// storage_wait_durable() returns the error
+static void storage_check(esp_err_t ret, const char *what)
+{
+    int expected = ESP_OK;
+    if (ret != ESP_OK && atomic_compare_exchange_strong(&storage_error, &expected, ret))
+    {
+        ESP_LOGE(LOG_TAG, "Failed to %s (%s), no further attempt is durable", what, esp_err_to_name(ret));
+        xTaskNotifyGive(attempt_task_handle);
+    }
+}
+
+// sync the journal and let the attempt loop know its attempts are on the card
+static void storage_commit(uint32_t *attempts)
+{
+    if (*attempts > 0)
+    {
+        storage_check(journal_commit(storage.journal), "sync the journal");
+        if (atomic_load(&storage_error) == ESP_OK)
+        {
+            atomic_fetch_add(&attempts_durable, *attempts);
+            xTaskNotifyGive(attempt_task_handle);
+        }
+        *attempts = 0;
+    }
+}
+
+static void storage_card_power(bool on)
+{
+    if (card_suspended == !on)
+    {
+        return;
+    }
+    card_suspended = !on;
+    if (storage.card_power != NULL)
+    {
+        storage_check(storage.card_power(on), on ? "bring the card back up" : "power the card down");
+    }
+}
+
+static void storage_task(void *arg)
+{
+    for (;;)
+    {
+        storage_request_t request;
+        uint32_t attempts = 0;
+        bool stop = false;
+        while (spsc_queue_pop(&request_queue, &request))
+        {
+            // nothing touches the card while it is powered down
+            if (request.type == STORAGE_REQUEST_ATTEMPT || request.type == STORAGE_REQUEST_CHECKPOINT)
+            {
+                storage_card_power(true);
+            }
+
+            switch (request.type)
+            {
+            case STORAGE_REQUEST_ATTEMPT:
+                storage_check(journal_append(storage.journal, &request.record), "append to the journal");
+                attempts++;
+                break;
+            case STORAGE_REQUEST_CHECKPOINT:
+                // the checkpoint must never get ahead of the set, or a reboot would skip passcodes
+                // it has not recorded as tried
+                if (storage.visited != NULL)
+                {
+                    esp_err_t ret = visited_save(storage.visited);
+                    storage_check(ret, "save the visited set");
+                    if (ret != ESP_OK)
+                    {
+                        break;
+                    }
+                }
+                storage.checkpoint->state = request.checkpoint;
+                storage_check(checkpoint_save(storage.checkpoint), "save the checkpoint");
+                break;
+            case STORAGE_REQUEST_SUSPEND:
+                storage_commit(&attempts);
+                storage_card_power(false);
+                break;
+            case STORAGE_REQUEST_RESUME:
+                storage_card_power(true);
+                break;
+            case STORAGE_REQUEST_STOP:
+                storage_card_power(true);
+                stop = true;
+                break;
+            }
+        }
+
+        // one sync covers every attempt drained above
+        storage_commit(&attempts);
+
+        if (stop)
+        {
+            break;
+        }
+
+        if (card_suspended)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        storage_fill_passcodes();
+
+        // with the queues serviced, load the next dictionary block so the following
+        // read ahead is served from memory
+        dict_chain_prefetch(storage.chain);
+
+        // sleep until the attempt loop queues a write or drains passcodes
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    journal_close(storage.journal);
+    checkpoint_close(storage.checkpoint);
+    if (storage.visited != NULL)
+    {
+        visited_close(storage.visited);
+    }
+    dict_chain_close(storage.chain);
+    atomic_store(&storage_stopped, true);
+    xTaskNotifyGive(attempt_task_handle);
+    vTaskDelete(NULL);
+}
+
+esp_err_t storage_task_start(const storage_config_t *config)
+{
+    storage = *config;
+    attempt_task_handle = xTaskGetCurrentTaskHandle();
+    atomic_init(&storage_error, ESP_OK);
+    spsc_queue_init(&passcode_queue, passcode_buffer, sizeof(passcode_buffer[0]), STORAGE_PASSCODE_QUEUE_LEN);
+    spsc_queue_init(&request_queue, request_buffer, sizeof(request_buffer[0]), STORAGE_REQUEST_QUEUE_LEN);
+
+    if (xTaskCreatePinnedToCore(storage_task, "storage", STORAGE_TASK_STACK_SIZE, NULL,
+                                STORAGE_TASK_PRIORITY, &storage_task_handle, STORAGE_TASK_CORE) != pdPASS)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to create storage task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+// push a request, only ever waits if the card has fallen a whole queue behind
+static void storage_request(const storage_request_t *request)
+{
+    while (!spsc_queue_push(&request_queue, request))
+    {
+        xTaskNotifyGive(storage_task_handle);
+        vTaskDelay(1);
+    }
+    xTaskNotifyGive(storage_task_handle);
+}
+
+esp_err_t storage_next_passcode(uint32_t *index, candidate_t *candidate)
+{
+    if (passcodes_end != ESP_OK)
+    {
+        return passcodes_end;
+    }
+
+    storage_passcode_t item;
+    while (!spsc_queue_pop(&passcode_queue, &item))
+    {
+        // only happens before the first read ahead completes
+        xTaskNotifyGive(storage_task_handle);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    // wake the storage task to top up once half the read ahead has been used
+    if (spsc_queue_count(&passcode_queue) < STORAGE_PASSCODE_QUEUE_LEN / 2)
+    {
+        xTaskNotifyGive(storage_task_handle);
+    }
+
+    if (item.result != ESP_OK)
+    {
+        passcodes_end = item.result;
+        return passcodes_end;
+    }
+    *index = item.index;
+    *candidate = item.candidate;
+    return ESP_OK;
+}
+
+uint32_t storage_log_attempt(const journal_record_t *record)
+{
+    storage_request_t request = {
+        .type = STORAGE_REQUEST_ATTEMPT,
+        .record = *record,
+    };
+    storage_request(&request);
+
+    return ++attempts_queued;
+}
+
+esp_err_t storage_wait_durable(uint32_t ticket, TickType_t timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (atomic_load(&attempts_durable) < ticket)
+    {
+        esp_err_t error = atomic_load(&storage_error);
+        if (error != ESP_OK)
+        {
+            return error;
+        }
+
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout)
+        {
+            ESP_LOGW(LOG_TAG, "Attempt %lu not on the card yet", (unsigned long)ticket);
+            return ESP_ERR_TIMEOUT;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - waited);
+    }
+
+    return ESP_OK;
+}
+
+void storage_save_checkpoint(const checkpoint_state_t *state)
+{
+    storage_request_t request = {
+        .type = STORAGE_REQUEST_CHECKPOINT,
+        .checkpoint = *state,
+    };
+    storage_request(&request);
+}
+
+void storage_suspend(void)
+{
+    storage_request_t request = {
+        .type = STORAGE_REQUEST_SUSPEND,
+    };
+    storage_request(&request);
+}
+
+void storage_resume(void)
+{
+    storage_request_t request = {
+        .type = STORAGE_REQUEST_RESUME,
+    };
+    storage_request(&request);
+}
+
+void storage_task_stop(void)
+{
+    storage_request_t request = {
+        .type = STORAGE_REQUEST_STOP,
+    };
+    storage_request(&request);
+
+    // the storage task notifies once more after closing the files
+    while (!atomic_load(&storage_stopped))
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+static esp_err_t storage_backend_next_passcode(void *ctx, uint32_t *index, candidate_t *candidate)
+{
+    return storage_next_passcode(index, candidate);
+}
+
+static uint32_t storage_backend_log_attempt(void *ctx, const journal_record_t *record)
+{
+    return storage_log_attempt(record);
+}
+
+static esp_err_t storage_backend_wait_durable(void *ctx, uint32_t ticket)
+{
+    return storage_wait_durable(ticket, pdMS_TO_TICKS(STORAGE_DURABLE_TIMEOUT_MS));
+}
+
+static void storage_backend_save_checkpoint(void *ctx, const checkpoint_state_t *state)
+{
+    storage_save_checkpoint(state);
+}
+
+static void storage_backend_suspend(void *ctx)
+{
+    storage_suspend();
+}
+
+static void storage_backend_resume(void *ctx)
+{
+    storage_resume();
+}
+
+const engine_storage_t storage_task_backend = {
+    .next_passcode = storage_backend_next_passcode,
+    .log_attempt = storage_backend_log_attempt,
+    .wait_durable = storage_backend_wait_durable,
+    .save_checkpoint = storage_backend_save_checkpoint,
+    .suspend = storage_backend_suspend,
+    .resume = storage_backend_resume,
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "dict_chain.h"
+#include "visited.h"
+#include "journal.h"
+#include "checkpoint.h"
+#include "engine.h"
+
+/**
+ * @brief SD card I/O task
+ *
+ * Owns the dictionaries, journal, checkpoint and visited set for the run. It is pinned to
+ * the core app_main is not on and talks to the attempt loop over two
+ * single-producer/single-consumer rings: one carrying passcodes read ahead
+ * from the dictionaries, the other carrying journal and checkpoint writes. The
+ * attempt loop never touches the card itself.
+ */
+
+#define STORAGE_TASK_CORE            1
+#define STORAGE_TASK_PRIORITY        4
+#define STORAGE_TASK_STACK_SIZE      4096
+#define STORAGE_PASSCODE_QUEUE_LEN   64      // passcodes read ahead, power of two
+#define STORAGE_REQUEST_QUEUE_LEN    16      // pending writes, power of two
+#define STORAGE_DURABLE_TIMEOUT_MS   2000    // longest the Enter keystroke waits for the journal
+
+typedef struct {
+    dict_chain_t *chain;                // positioned at the first passcode to hand out
+    journal_t *journal;
+    checkpoint_t *checkpoint;
+    visited_t *visited;                 // written back with each checkpoint, may be NULL
+    esp_err_t (*card_power)(bool on);   // powers the card down and back up while suspended, may be NULL.
+                                        // A card that does not come back fails every later write
+} storage_config_t;
+
+// hand the open files over to a new storage task; the caller must not touch them afterwards.
+// The calling task becomes the one allowed to use the functions below
+esp_err_t storage_task_start(const storage_config_t *config);
+
+// next passcode from the dictionaries, ESP_ERR_NOT_FOUND once the last one is exhausted or the
+// error that stopped the dictionaries being read, for this and every later call
+esp_err_t storage_next_passcode(uint32_t *index, candidate_t *candidate);
+
+// queue an attempt record for the journal, returns a ticket for storage_wait_durable()
+uint32_t storage_log_attempt(const journal_record_t *record);
+
+// block until the attempt with `ticket` is synced to the card, normally returns at once. Once any
+// write to the card has failed this returns that error for every attempt not already synced, as
+// does a checkpoint or visited set that could not be saved
+esp_err_t storage_wait_durable(uint32_t ticket, TickType_t timeout);
+
+// queue a checkpoint write, preceded by the visited set's marked pages
+void storage_save_checkpoint(const checkpoint_state_t *state);
+
+// sync outstanding writes and power the card down; the card is left alone until storage_resume()
+void storage_suspend(void);
+
+// power the card back up, writes queued from here on reach it as usual
+void storage_resume(void);
+
+// flush outstanding writes, close the files and end the storage task
+void storage_task_stop(void);
+
+// the functions above as an attempt engine storage backend
+extern const engine_storage_t storage_task_backend;
@@ -0,0 +1,93 @@
+#include <stdbool.h>
+#include <string.h>
+#include "text_tokenizer.h"
+#include "dict_format.h"
+
+#define TEXT_TOKENIZER_EOF     -1
+
+esp_err_t text_tokenizer_open(text_tokenizer_t *tok, const char *path)
+{
+    memset(tok, 0, sizeof(*tok));
+    tok->block = BLOCK_READER_NO_BLOCK;
+
+    return block_reader_open(&tok->reader, path);
+}
+
+void text_tokenizer_close(text_tokenizer_t *tok)
+{
+    block_reader_close(&tok->reader);
+}
+
+// next byte of the file, moving on to the following block when this one is used up
+static int text_tokenizer_peek(text_tokenizer_t *tok)
+{
+    while (tok->pos == tok->length)
+    {
+        uint32_t next = tok->block + 1;     // wraps from BLOCK_READER_NO_BLOCK to block 0
+        tok->data = block_reader_get(&tok->reader, next, &tok->length);
+        if (tok->data == NULL)
+        {
+            tok->length = 0;
+            tok->pos = 0;
+            return TEXT_TOKENIZER_EOF;
+        }
+        tok->block = next;
+        tok->pos = 0;
+    }
+
+    return tok->data[tok->pos];
+}
+
+static bool text_tokenizer_is_space(int c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+esp_err_t text_tokenizer_next(text_tokenizer_t *tok, candidate_t *candidate)
+{
+    int c;
+    while ((c = text_tokenizer_peek(tok)) != TEXT_TOKENIZER_EOF && text_tokenizer_is_space(c))
+    {
+        if (c == '\n')
+        {
+            tok->newlines++;
+        }
+        tok->pos++;
+    }
+    if (c == TEXT_TOKENIZER_EOF)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // consume the whole token even if it turns out to be bad, so the next call starts afresh
+    tok->line = tok->newlines + 1;
+    uint32_t value = 0;
+    uint32_t digits = 0;
+    bool numeric = true;
+    while ((c = text_tokenizer_peek(tok)) != TEXT_TOKENIZER_EOF && !text_tokenizer_is_space(c))
+    {
+        if (c < '0' || c > '9')
+        {
+            numeric = false;
+        }
+        else if (digits < DICT_MAX_DIGITS)
+        {
+            value = value * 10 + (c - '0');
+        }
+        digits++;
+        tok->pos++;
+    }
+
+    if (!numeric)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (digits > DICT_MAX_DIGITS)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    candidate->value = value;
+    candidate->digits = digits;
+
+    return ESP_OK;
+}
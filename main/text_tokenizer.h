@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "block_reader.h"
+#include "candidate.h"
+
+/**
+ * @brief Streaming reader for text passcode lists
+ *
+ * Walks a text dictionary (misc/PIN*.TXT style, one candidate per line)
+ * straight out of the block reader's buffers, without stdio or fscanf.
+ * Candidates are separated by any whitespace, so CRLF line endings and
+ * blank lines are fine, and keep their length, so "000123" comes back as
+ * 123 with 6 digits.
+ */
+
+typedef struct {
+    block_reader_t reader;
+    const uint8_t *data;                // block being scanned
+    size_t length;                      // valid bytes in `data`
+    size_t pos;                         // next byte within `data`
+    uint32_t block;                     // block number of `data`
+    uint32_t line;                      // line the last candidate (or bad token) was on, from 1
+    uint32_t newlines;                  // line breaks seen so far
+} text_tokenizer_t;
+
+esp_err_t text_tokenizer_open(text_tokenizer_t *tok, const char *path);
+
+void text_tokenizer_close(text_tokenizer_t *tok);
+
+// read the next candidate. Returns ESP_ERR_NOT_FOUND at the end of the file, ESP_ERR_INVALID_ARG
+// for a token that is not all digits and ESP_ERR_INVALID_SIZE for one longer than
+// DICT_MAX_DIGITS; tok->line says where. Bad tokens are skipped, so reading can carry on
+esp_err_t text_tokenizer_next(text_tokenizer_t *tok, candidate_t *candidate);
@@ -0,0 +1,66 @@
+#include "esp_log.h"
+#include "freertos/event_groups.h"
+#include "tinyusb.h"
+#include "usb_link.h"
+
+#define LOG_TAG                "usb_link"
+
+#define USB_LINK_MOUNTED       BIT0            // configured by the host
+#define USB_LINK_SUSPENDED     BIT1
+#define USB_LINK_ACTIVE        BIT2            // mounted and not suspended, what keystrokes need
+#define USB_LINK_WAKEUP_OK     BIT3            // the host allows remote wakeup from the current suspend
+
+static EventGroupHandle_t link_state;
+
+esp_err_t usb_link_init(void)
+{
+    link_state = xEventGroupCreate();
+    return link_state != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+bool usb_link_wait_active(TickType_t timeout)
+{
+    EventBits_t bits = xEventGroupGetBits(link_state);
+    if ((bits & (USB_LINK_SUSPENDED | USB_LINK_WAKEUP_OK)) == (USB_LINK_SUSPENDED | USB_LINK_WAKEUP_OK))
+    {
+        // only once per suspend, the host decides when to resume
+        xEventGroupClearBits(link_state, USB_LINK_WAKEUP_OK);
+        ESP_LOGI(LOG_TAG, "Waking the host");
+        tud_remote_wakeup();
+    }
+
+    bits = xEventGroupWaitBits(link_state, USB_LINK_ACTIVE, pdFALSE, pdTRUE, timeout);
+    return (bits & USB_LINK_ACTIVE) != 0;
+}
+
+// the callbacks below run in the TinyUSB task
+
+void tud_mount_cb(void)
+{
+    ESP_LOGI(LOG_TAG, "Mounted");
+    xEventGroupClearBits(link_state, USB_LINK_SUSPENDED | USB_LINK_WAKEUP_OK);
+    xEventGroupSetBits(link_state, USB_LINK_MOUNTED | USB_LINK_ACTIVE);
+}
+
+void tud_umount_cb(void)
+{
+    ESP_LOGI(LOG_TAG, "Unmounted");
+    xEventGroupClearBits(link_state, USB_LINK_MOUNTED | USB_LINK_ACTIVE | USB_LINK_SUSPENDED | USB_LINK_WAKEUP_OK);
+}
+
+void tud_suspend_cb(bool remote_wakeup_en)
+{
+    ESP_LOGI(LOG_TAG, "Suspended%s", remote_wakeup_en ? ", remote wakeup allowed" : "");
+    xEventGroupClearBits(link_state, USB_LINK_ACTIVE);
+    xEventGroupSetBits(link_state, USB_LINK_SUSPENDED | (remote_wakeup_en ? USB_LINK_WAKEUP_OK : 0));
+}
+
+void tud_resume_cb(void)
+{
+    ESP_LOGI(LOG_TAG, "Resumed");
+    xEventGroupClearBits(link_state, USB_LINK_SUSPENDED | USB_LINK_WAKEUP_OK);
+    if (xEventGroupGetBits(link_state) & USB_LINK_MOUNTED)
+    {
+        xEventGroupSetBits(link_state, USB_LINK_ACTIVE);
+    }
+}
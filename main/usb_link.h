@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief State of the USB link to the target, driven by TinyUSB's callbacks
+ *
+ * tud_mount_cb(), tud_umount_cb(), tud_suspend_cb() and tud_resume_cb() set
+ * and clear bits in an event group, so waiting for the host is a blocking
+ * wait that returns as soon as the TinyUSB task sees the change instead of
+ * polling tud_mounted().
+ */
+
+// create the event group, before tinyusb_driver_install()
+esp_err_t usb_link_init(void);
+
+// wait up to `timeout` for the host to have the device configured and not suspended, asking a
+// suspended host that allows it for a remote wakeup first. Returns whether it is
+bool usb_link_wait_active(TickType_t timeout);
@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "visited.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#define LOG_TAG                "visited"
+
+// lengths 1 to 6 take 39 pages, which the 64 bit dirty mask has to cover
+_Static_assert(VISITED_MAX_DIGITS <= 6, "dirty page mask too small for the file");
+
+static uint8_t *visited_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    // the larger bitmaps are better off in PSRAM, if the board has it and the build enables it
+    uint8_t *bits = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM);
+    if (bits == NULL)
+    {
+        bits = heap_caps_calloc(1, size, MALLOC_CAP_8BIT);
+    }
+    return bits;
+#else
+    return calloc(1, size);
+#endif
+}
+
+static void visited_free(uint8_t *bits)
+{
+#ifdef ESP_PLATFORM
+    heap_caps_free(bits);
+#else
+    free(bits);
+#endif
+}
+
+// bytes in the bitmap for `digits` digit passcodes
+static uint32_t visited_bytes(int digits)
+{
+    uint32_t values = 1;
+    for (int i = 0; i < digits; i++)
+    {
+        values *= 10;
+    }
+    return (values + 7) / 8;
+}
+
+// file offset of the bitmap for `digits` digit passcodes; the regions follow each other in
+// order of length, each starting on a page
+static uint32_t visited_region_offset(int digits)
+{
+    uint32_t offset = 0;
+    for (int i = 1; i < digits; i++)
+    {
+        offset += (visited_bytes(i) + VISITED_PAGE_SIZE - 1) / VISITED_PAGE_SIZE * VISITED_PAGE_SIZE;
+    }
+    return offset;
+}
+
+// fill a new file with empty regions for every length, tracked or not
+static esp_err_t visited_create(visited_t *visited, uint32_t size)
+{
+    uint8_t *page = calloc(1, VISITED_PAGE_SIZE);
+    if (page == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (fseek(visited->file, 0, SEEK_SET) != 0)
+    {
+        ret = ESP_FAIL;
+    }
+    for (uint32_t offset = 0; ret == ESP_OK && offset < size; offset += VISITED_PAGE_SIZE)
+    {
+        if (fwrite(page, VISITED_PAGE_SIZE, 1, visited->file) != 1)
+        {
+            ret = ESP_FAIL;
+        }
+    }
+    if (ret == ESP_OK && (fflush(visited->file) != 0 || fsync(fileno(visited->file)) != 0))
+    {
+        ret = ESP_FAIL;
+    }
+
+    free(page);
+    return ret;
+}
+
+esp_err_t visited_open(visited_t *visited, const char *path, uint32_t lengths)
+{
+    memset(visited, 0, sizeof(*visited));
+    atomic_init(&visited->dirty, 0);
+
+    visited->file = fopen(path, "r+b");
+    if (visited->file == NULL)
+    {
+        visited->file = fopen(path, "w+b");
+    }
+    if (visited->file == NULL)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+
+    // anything but the expected size is a new (or unusable) file and starts out empty
+    uint32_t size = visited_region_offset(VISITED_MAX_DIGITS + 1);
+    bool fresh = fseek(visited->file, 0, SEEK_END) != 0 || ftell(visited->file) != (long)size;
+    if (fresh && visited_create(visited, size) != ESP_OK)
+    {
+        ESP_LOGE(LOG_TAG, "Failed to create %s", path);
+        visited_close(visited);
+        return ESP_FAIL;
+    }
+
+    uint32_t tried = 0;
+    for (int digits = 1; digits <= VISITED_MAX_DIGITS; digits++)
+    {
+        if ((lengths & (1u << digits)) == 0)
+        {
+            continue;
+        }
+
+        uint32_t bytes = visited_bytes(digits);
+        visited->bits[digits] = visited_alloc(bytes);
+        if (visited->bits[digits] == NULL)
+        {
+            ESP_LOGE(LOG_TAG, "No memory for the %d digit bitmap (%lu bytes)", digits, (unsigned long)bytes);
+            visited_close(visited);
+            return ESP_ERR_NO_MEM;
+        }
+        if (fresh)
+        {
+            continue;
+        }
+
+        if (fseek(visited->file, visited_region_offset(digits), SEEK_SET) != 0
+            || fread(visited->bits[digits], bytes, 1, visited->file) != 1)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to read the %d digit bitmap", digits);
+            visited_close(visited);
+            return ESP_FAIL;
+        }
+        for (uint32_t i = 0; i < bytes; i++)
+        {
+            tried += __builtin_popcount(visited->bits[digits][i]);
+        }
+    }
+    if (lengths >> (VISITED_MAX_DIGITS + 1) != 0)
+    {
+        ESP_LOGW(LOG_TAG, "Passcodes over %d digits are not tracked, duplicates among them will be tried again",
+                 VISITED_MAX_DIGITS);
+    }
+
+    ESP_LOGI(LOG_TAG, "%lu passcodes tried before", (unsigned long)tried);
+    return ESP_OK;
+}
+
+void visited_close(visited_t *visited)
+{
+    for (int digits = 0; digits <= VISITED_MAX_DIGITS; digits++)
+    {
+        if (visited->bits[digits] != NULL)
+        {
+            visited_free(visited->bits[digits]);
+            visited->bits[digits] = NULL;
+        }
+    }
+    if (visited->file != NULL)
+    {
+        fclose(visited->file);
+        visited->file = NULL;
+    }
+}
+
+bool visited_test(const visited_t *visited, const candidate_t *candidate)
+{
+    if (candidate->digits > VISITED_MAX_DIGITS || visited->bits[candidate->digits] == NULL)
+    {
+        return false;
+    }
+    return (visited->bits[candidate->digits][candidate->value >> 3] & (1u << (candidate->value & 7))) != 0;
+}
+
+void visited_mark(visited_t *visited, const candidate_t *candidate)
+{
+    if (candidate->digits > VISITED_MAX_DIGITS || visited->bits[candidate->digits] == NULL)
+    {
+        return;
+    }
+
+    uint32_t byte = candidate->value >> 3;
+    visited->bits[candidate->digits][byte] |= 1u << (candidate->value & 7);
+
+    uint32_t page = (visited_region_offset(candidate->digits) + byte) / VISITED_PAGE_SIZE;
+    atomic_fetch_or(&visited->dirty, (uint_fast64_t)1 << page);
+}
+
+esp_err_t visited_save(visited_t *visited)
+{
+    uint_fast64_t dirty = atomic_exchange(&visited->dirty, 0);
+    if (dirty == 0)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (int digits = 1; digits <= VISITED_MAX_DIGITS && ret == ESP_OK; digits++)
+    {
+        if (visited->bits[digits] == NULL)
+        {
+            continue;
+        }
+
+        // write back the dirty pages of this length's region, the region's last page only up to its end
+        uint32_t region = visited_region_offset(digits);
+        uint32_t bytes = visited_bytes(digits);
+        for (uint32_t start = 0; start < bytes; start += VISITED_PAGE_SIZE)
+        {
+            uint32_t page = (region + start) / VISITED_PAGE_SIZE;
+            if ((dirty & ((uint_fast64_t)1 << page)) == 0)
+            {
+                continue;
+            }
+
+            uint32_t length = bytes - start < VISITED_PAGE_SIZE ? bytes - start : VISITED_PAGE_SIZE;
+            if (fseek(visited->file, region + start, SEEK_SET) != 0
+                || fwrite(visited->bits[digits] + start, length, 1, visited->file) != 1)
+            {
+                ret = ESP_FAIL;
+                break;
+            }
+        }
+    }
+    if (ret == ESP_OK && (fflush(visited->file) != 0 || fsync(fileno(visited->file)) != 0))
+    {
+        ret = ESP_FAIL;
+    }
+
+    if (ret != ESP_OK)
+    {
+        // try these pages again with the next save
+        atomic_fetch_or(&visited->dirty, dirty);
+        ESP_LOGE(LOG_TAG, "Failed to save the visited set");
+    }
+    return ret;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "candidate.h"
+
+/**
+ * @brief Set of passcodes already tried on the target
+ *
+ * One bit per possible value of each passcode length, 10^N bits for N
+ * digits (125 KB for six), so a test or a mark is a single bit operation
+ * whichever dictionary the candidate came from. The bitmaps live in PSRAM
+ * when the build has it and in internal RAM otherwise, and are kept in a
+ * file next to the checkpoint: one page-aligned region per length, of which
+ * only the pages marked since the last save are written back.
+ *
+ * The set belongs to the target, not to a dictionary, so it survives
+ * changing the dictionaries; delete the file to start on a new target.
+ * Lengths above VISITED_MAX_DIGITS are not tracked and always test false.
+ */
+
+#define VISITED_MAX_DIGITS     6       // longest tracked length, the dirty page mask has to cover the file
+#define VISITED_PAGE_SIZE      4096    // matches CONFIG_FATFS_SECTOR_4096
+
+typedef struct {
+    FILE *file;
+    uint8_t *bits[VISITED_MAX_DIGITS + 1];  // bitmap per length, NULL if that length is not tracked
+    atomic_uint_fast64_t dirty;         // file pages marked since the last visited_save(), a bit each
+} visited_t;
+
+// open (creating if needed) the set in `path` and load the bitmaps for the lengths in `lengths`,
+// a mask with bit N set for N digit passcodes
+esp_err_t visited_open(visited_t *visited, const char *path, uint32_t lengths);
+
+void visited_close(visited_t *visited);
+
+// whether `candidate` has been marked
+bool visited_test(const visited_t *visited, const candidate_t *candidate);
+
+// mark `candidate` as tried. Only one task may mark, any may test
+void visited_mark(visited_t *visited, const candidate_t *candidate);
+
+// durably write the pages marked since the last save
+esp_err_t visited_save(visited_t *visited);
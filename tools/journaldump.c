@@ -0,0 +1,102 @@
+// Host-side dump of an attempt journal (ATTEMPTS.JNL, see main/journal.h) as text,
+// one attempt, session, boot timing or latency summary per line, stopping at the first record that fails validation
+//
+// Build and run:
+//   cc -O2 -Imain -o journaldump tools/journaldump.c main/crc32.c
+//   ./journaldump /media/sdcard/ATTEMPTS.JNL
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "journal_format.h"
+#include "crc32.h"
+
+// esp_reset_reason_t names, which the session record stores as a number
+static const char *const reset_reasons[] = {
+    "unknown", "power on", "external", "software", "panic", "interrupt watchdog", "task watchdog",
+    "watchdog", "deep sleep", "brownout", "SDIO", "USB", "JTAG", "eFuse", "power glitch", "CPU lockup",
+};
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <ATTEMPTS.JNL>\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    journal_file_header_t header;
+    if (fread(&header, sizeof(header), 1, f) != 1
+        || memcmp(header.magic, JOURNAL_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != JOURNAL_VERSION
+        || header.crc32 != crc32_update(0, &header, offsetof(journal_file_header_t, crc32)))
+    {
+        fprintf(stderr, "%s: not a journal\n", argv[1]);
+        fclose(f);
+        return 1;
+    }
+
+    journal_record_t record;
+    uint32_t sequence = 1;
+    while (fread(&record, sizeof(record), 1, f) == 1)
+    {
+        // blank (preallocated) or stale slots end the journal
+        if (record.magic != JOURNAL_RECORD_MAGIC || record.sequence != sequence)
+        {
+            break;
+        }
+        if (record.crc32 != crc32_update(header.epoch, &record, offsetof(journal_record_t, crc32)))
+        {
+            fprintf(stderr, "%s: record %lu fails its CRC, stopping\n", argv[1], (unsigned long)sequence);
+            break;
+        }
+
+        time_t seconds = record.timestamp_us / 1000000;
+        char timestr[32];
+        strftime(timestr, sizeof(timestr), "%Y-%m-%d %H:%M:%S", gmtime(&seconds));
+
+        if (record.type == JOURNAL_RECORD_ATTEMPT)
+        {
+            printf("%lu\t%s\t#%lu\t%0*lu\n", (unsigned long)record.sequence, timestr,
+                   (unsigned long)record.dict_index, record.digits, (unsigned long)record.passcode);
+        }
+        else if (record.type == JOURNAL_RECORD_SESSION)
+        {
+            const char *reason = record.reset_reason < sizeof(reset_reasons) / sizeof(reset_reasons[0])
+                ? reset_reasons[record.reset_reason] : "unknown";
+            printf("%lu\t%s\tsession\t%s reset, SD %u-bit %u kHz, write %u KB/s, read %u KB/s\n",
+                   (unsigned long)record.sequence, timestr, reason, record.sd_bus_width, record.sd_freq_khz,
+                   record.sd_write_kbps, record.sd_read_kbps);
+        }
+        else if (record.type == JOURNAL_RECORD_BOOT)
+        {
+            static const char *const names[JOURNAL_BOOT_TIMES] = { "USB", "card", "files", "resumed" };
+            printf("%lu\t%s\tboot\t", (unsigned long)record.sequence, timestr);
+            for (int i = 0; i < JOURNAL_BOOT_TIMES; i++)
+            {
+                uint32_t ms = journal_boot_ms(&record, i);
+                printf("%s%s %s%lu ms", i > 0 ? ", " : "", names[i], ms == JOURNAL_BOOT_MS_MAX ? ">= " : "",
+                       (unsigned long)ms);
+            }
+            printf(" after reset\n");
+        }
+        else if (record.type == JOURNAL_RECORD_LATENCY)
+        {
+            printf("%lu\t%s\tlatency\t%u samples, p50 < %u ms, p95 < %u ms, max %u ms\n",
+                   (unsigned long)record.sequence, timestr, record.latency_samples, record.latency_p50_ms,
+                   record.latency_p95_ms, record.latency_max_ms);
+        }
+        sequence++;
+    }
+
+    fclose(f);
+    return 0;
+}
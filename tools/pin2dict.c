@@ -0,0 +1,52 @@
+// Host-side converter from a text passcode list (one candidate per line, as in
+// misc/PIN*.TXT) to the packed dictionary format described in main/dict_format.h.
+// The conversion itself is main/dict_build.c, which the firmware also uses
+//
+// Build and run:
+//   cmake -S host -B build-host && cmake --build build-host --target pin2dict
+//   ./build-host/pin2dict [-z] misc/PIN4.TXT PIN4.DIC
+//
+// -z writes the compressed (frame-of-reference bit packed) format
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "dict.h"
+#include "dict_build.h"
+
+int main(int argc, char **argv)
+{
+    bool compressed = argc == 4 && strcmp(argv[1], "-z") == 0;
+    if (argc != 3 && !compressed)
+    {
+        fprintf(stderr, "usage: %s [-z] <input.txt> <output.dic>\n", argv[0]);
+        return 2;
+    }
+    const char *text_path = argv[argc - 2];
+    const char *dict_path = argv[argc - 1];
+
+    if (dict_build(text_path, dict_path, compressed) != ESP_OK)
+    {
+        return 1;
+    }
+
+    dict_t dict;
+    if (dict_open(&dict, dict_path) != ESP_OK)
+    {
+        return 1;
+    }
+    if (compressed)
+    {
+        printf("%s: %lu passcodes of %d digits, %lu bytes compressed (%.1f bits each), crc32 %08lx\n",
+               dict_path, (unsigned long)dict.count, dict.digits, (unsigned long)dict.reader.size,
+               dict.count > 0 ? 8.0 * dict.reader.size / dict.count : 0.0, (unsigned long)dict.crc32);
+    }
+    else
+    {
+        printf("%s: %lu passcodes of %d digits, %d bytes each, crc32 %08lx\n",
+               dict_path, (unsigned long)dict.count, dict.digits, dict.entry_size, (unsigned long)dict.crc32);
+    }
+    dict_close(&dict);
+
+    return 0;
+}
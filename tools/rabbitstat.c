@@ -0,0 +1,115 @@
+// Host-side reader for the firmware's USB status channel (see main/status_format.h),
+// printing one line per status frame, optionally after sending a command
+//
+// Build and run:
+//   cc -O2 -Imain -o rabbitstat tools/rabbitstat.c main/crc32.c
+//   ./rabbitstat /dev/ttyACM0            follow the status
+//   ./rabbitstat /dev/ttyACM0 pause      pause the run (or resume), then follow
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "status_format.h"
+#include "crc32.h"
+
+static int usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s <tty> [pause|resume]\n", argv0);
+    return 2;
+}
+
+static void print_frame(const status_frame_t *frame)
+{
+    printf("%8.1fs  #%-8lu attempts %-6lu window %lu/%lu  lockout %llds  next in %llds  sync %lu us%s%s\n",
+           frame->uptime_us / 1e6, (unsigned long)frame->index, (unsigned long)frame->attempts_made,
+           (unsigned long)frame->schedule_window_attempts, (unsigned long)frame->schedule_attempts,
+           (long long)(frame->lockout_us / 1000000), (long long)(frame->wait_us / 1000000),
+           (unsigned long)frame->durable_wait_us,
+           (frame->flags & STATUS_FLAG_PAUSED) ? "  PAUSED" : "",
+           (frame->flags & STATUS_FLAG_DONE) ? "  DONE" : "");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        return usage(argv[0]);
+    }
+
+    char command = 0;
+    if (argc == 3)
+    {
+        if (strcmp(argv[2], "pause") == 0)
+        {
+            command = STATUS_CMD_PAUSE;
+        }
+        else if (strcmp(argv[2], "resume") == 0)
+        {
+            command = STATUS_CMD_RESUME;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    // opening the port raises DTR, which is what starts the firmware sending
+    int fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    if (command != 0 && write(fd, &command, 1) != 1)
+    {
+        perror(argv[1]);
+        close(fd);
+        return 1;
+    }
+
+    // slide along the byte stream until a whole, valid frame lines up
+    uint8_t buffer[2 * STATUS_FRAME_SIZE];
+    size_t length = 0;
+    for (;;)
+    {
+        ssize_t got = read(fd, buffer + length, sizeof(buffer) - length);
+        if (got <= 0)
+        {
+            break;
+        }
+        length += got;
+
+        while (length >= STATUS_FRAME_SIZE)
+        {
+            status_frame_t frame;
+            memcpy(&frame, buffer, sizeof(frame));
+            if (frame.magic == STATUS_FRAME_MAGIC
+                && frame.version == STATUS_VERSION
+                && frame.size == STATUS_FRAME_SIZE
+                && frame.crc32 == crc32_update(0, &frame, offsetof(status_frame_t, crc32)))
+            {
+                print_frame(&frame);
+                length -= STATUS_FRAME_SIZE;
+                memmove(buffer, buffer + STATUS_FRAME_SIZE, length);
+            }
+            else
+            {
+                length--;
+                memmove(buffer, buffer + 1, length);
+            }
+        }
+    }
+
+    close(fd);
+    return 0;
+}